@@ -0,0 +1,81 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <vector>
+
+#include "prewarmed.h"
+
+using namespace std::literals;
+
+/*
+ * Startup simulation
+ * - Opening the connection takes 300ms
+ * - The rest of the program's startup takes "startup" ms
+ * - Then requests arrive, every request calls process()
+ *
+ * - Without pre-warming, the first request waits the full 300ms
+ * - With pre-warming, the connection is built while the rest of startup runs
+ *      - The first request only waits for whatever is left
+ *      - If startup takes longer than 300ms, nobody waits at all
+ *      */
+
+class Connection {
+public:
+    std::string host;
+
+    explicit Connection(std::string host) : host(std::move(host))
+    {
+        std::this_thread::sleep_for(300ms);
+    }
+
+    int query() const {return 42;}
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+void simulate(bool prewarm, std::chrono::milliseconds startup)
+{
+    Prewarmed<Connection> connection([] {return Connection("db.example.com");});
+
+    auto start = bench_clock::now();
+    if (prewarm) {
+        connection.prewarm();
+    }
+
+    // The rest of startup: reading config, loading caches...
+    std::this_thread::sleep_for(startup);
+
+    // Four requests arrive at once
+    std::mutex worst_mut;
+    std::chrono::microseconds worst {0};
+    std::vector<std::thread> requests;
+    for (int i = 0; i < 4; ++i) {
+        requests.emplace_back([&] {
+            auto before = bench_clock::now();
+            connection.get().query();
+            auto latency = std::chrono::duration_cast<std::chrono::microseconds>(bench_clock::now() - before);
+            std::lock_guard<std::mutex> lck_guard(worst_mut);
+            worst = std::max(worst, latency);
+        });
+    }
+    for (auto &thr : requests) {
+        thr.join();
+    }
+
+    auto total = std::chrono::duration_cast<std::chrono::milliseconds>(bench_clock::now() - start);
+    std::cout << (prewarm ? "prewarm   " : "lazy only ") << "startup " << startup.count() << " ms: "
+              << "time to ready " << std::chrono::duration_cast<std::chrono::milliseconds>(connection.time_to_ready()).count()
+              << " ms, worst first-request latency " << worst.count() / 1000.0
+              << " ms, longest get() block " << std::chrono::duration_cast<std::chrono::milliseconds>(connection.blocked_time()).count()
+              << " ms, until first answers " << total.count() << " ms" << std::endl;
+}
+
+int main() {
+    for (auto startup : {0ms, 100ms, 200ms, 400ms}) {
+        simulate(false, startup);
+        simulate(true, startup);
+    }
+    return 0;
+}
@@ -0,0 +1,166 @@
+#ifndef ASYNC_PREWARM_PREWARMED_H
+#define ASYNC_PREWARM_PREWARMED_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "lazy_init.h"
+
+/*
+ * Pre-warming a Lazily Initialized Object
+ *
+ * - Lazy initialization saves work if the object is never used
+ * - But whoever calls process() first pays the whole construction cost
+ *      - e.g. opening a network connection while a request is waiting for an answer
+ *      - This shows up as a slow first request after every restart
+ *
+ * - Prewarmed<T>
+ *      - prewarm() starts building the object on a background thread
+ *      - The program carries on with the rest of its startup
+ *      - get() returns at once if the object is ready
+ *      - Otherwise get() blocks, but only for whatever construction time is left
+ *      - If nobody called prewarm(), get() builds the object itself, like LazyInit
+ *
+ * - It is a LazyInit<T> underneath
+ *      - The background thread is just another caller of get()
+ *      - If it is still constructing when a worker calls get(), the worker sleeps until it is done
+ *      - If the background construction throws, the next get() or prewarm() tries again
+ *
+ * - Timings
+ *      - time_to_ready(): from the start of construction (prewarm() or first get()) until ready
+ *      - blocked_time(): the longest any caller of get() had to wait
+ *      */
+
+template <typename T>
+class Prewarmed {
+private:
+    using clock = std::chrono::steady_clock;
+
+    LazyInit<T> lazy;
+    std::function<T()> factory;
+
+    std::mutex warmer_mut;
+    std::thread warmer;
+    std::atomic<bool> warmer_done {false};   // the thread has finished, it can be joined without waiting
+
+    // Nanoseconds since the epoch of clock, 0 = not yet
+    std::atomic<std::int64_t> started_at {0};
+    std::atomic<std::int64_t> ready_after {0};
+    std::atomic<std::int64_t> longest_block {0};
+
+    static std::int64_t now_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+
+    void mark_started()
+    {
+        std::int64_t expected_value {0};
+        started_at.compare_exchange_strong(expected_value, now_ns());
+    }
+
+    // Only runs in the thread which actually builds the object
+    // The timer's destructor runs once the returned T has been built in place, not if it threw
+    T build_and_time()
+    {
+        struct ReadyTimer {
+            Prewarmed *owner;
+            int exceptions = std::uncaught_exceptions();
+
+            ~ReadyTimer()
+            {
+                if (std::uncaught_exceptions() == exceptions) {
+                    owner->ready_after.store(now_ns() - owner->started_at.load());
+                }
+            }
+        } timer {this};
+        return factory();
+    }
+
+    T &build()
+    {
+        // Everything returns a prvalue, so T is built in place and need not be movable
+        return lazy.get_with([this] {return build_and_time();});
+    }
+
+public:
+    explicit Prewarmed(std::function<T()> factory) : factory(std::move(factory)) {}
+
+    Prewarmed(const Prewarmed &source) = delete;
+    Prewarmed &operator=(const Prewarmed &source) = delete;
+
+    ~Prewarmed()
+    {
+        std::lock_guard<std::mutex> lck_guard(warmer_mut);
+        if (warmer.joinable()) {
+            warmer.join();
+        }
+    }
+
+    // Start construction in the background
+    // Does nothing while it is running or once the object is ready, starts again after a failure
+    void prewarm()
+    {
+        std::lock_guard<std::mutex> lck_guard(warmer_mut);
+        if (lazy.is_ready()) {
+            return;
+        }
+        if (warmer.joinable()) {
+            if (!warmer_done.load()) {
+                return;
+            }
+            warmer.join();
+        }
+        warmer_done.store(false);
+        mark_started();
+        warmer = std::thread([this] {
+            try {
+                build();
+            }
+            catch (...) {
+                // The next get() or prewarm() tries again, and get() reports the error
+            }
+            warmer_done.store(true);
+        });
+    }
+
+    T &get()
+    {
+        if (T *object = lazy.try_get()) {
+            return *object;
+        }
+
+        mark_started();
+        std::int64_t before = now_ns();
+        T &object = build();
+        std::int64_t blocked = now_ns() - before;
+
+        std::int64_t longest = longest_block.load(std::memory_order_relaxed);
+        while (blocked > longest && !longest_block.compare_exchange_weak(longest, blocked)) {
+        }
+        return object;
+    }
+
+    bool is_ready() const
+    {
+        return lazy.is_ready();
+    }
+
+    std::chrono::nanoseconds time_to_ready() const
+    {
+        return std::chrono::nanoseconds(ready_after.load(std::memory_order_relaxed));
+    }
+
+    std::chrono::nanoseconds blocked_time() const
+    {
+        return std::chrono::nanoseconds(longest_block.load(std::memory_order_relaxed));
+    }
+};
+
+#endif //ASYNC_PREWARM_PREWARMED_H
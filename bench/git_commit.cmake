@@ -0,0 +1,12 @@
+# Run with cmake -P at build time: writes OUTPUT with BENCH_GIT_COMMIT defined
+execute_process(COMMAND git rev-parse --short HEAD
+        WORKING_DIRECTORY ${SOURCE_DIR}
+        OUTPUT_VARIABLE BENCH_GIT_COMMIT
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        ERROR_QUIET)
+if (NOT BENCH_GIT_COMMIT)
+    set(BENCH_GIT_COMMIT unknown)
+endif ()
+
+# Leaves the file alone when the content is the same
+file(CONFIGURE OUTPUT ${OUTPUT} CONTENT "#define BENCH_GIT_COMMIT \"${BENCH_GIT_COMMIT}\"\n")
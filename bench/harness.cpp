@@ -0,0 +1,231 @@
+#include "harness.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+// Generated on every build, see CMakeLists.txt
+#include "bench_git_commit.h"
+
+static std::vector<int> parse_thread_list(const std::string &text)
+{
+    std::vector<int> threads;
+    std::stringstream ss(text);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        int n = std::stoi(item);
+        if (n < 1) {
+            throw std::invalid_argument("thread counts must be at least 1");
+        }
+        threads.push_back(n);
+    }
+    if (threads.empty()) {
+        throw std::invalid_argument("--threads needs a list like 1,2,4");
+    }
+    return threads;
+}
+
+BenchConfig parse_bench_args(int argc, char *argv[])
+{
+    BenchConfig config;
+    config.label = BENCH_GIT_COMMIT;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        auto value = [&] () -> std::string {
+            if (i + 1 >= argc) {
+                throw std::invalid_argument(arg + " needs a value");
+            }
+            return argv[++i];
+        };
+
+        if (arg == "--warmup") {
+            config.warmup = std::stoi(value());
+        }
+        else if (arg == "--reps") {
+            config.reps = std::max(1, std::stoi(value()));
+        }
+        else if (arg == "--threads") {
+            config.threads = parse_thread_list(value());
+        }
+        else if (arg == "--pin") {
+            config.pin = true;
+        }
+        else if (arg == "--filter") {
+            config.filter = value();
+        }
+        else if (arg == "--label") {
+            config.label = value();
+        }
+        else if (arg == "--json") {
+            config.json_path = value();
+        }
+        else if (arg == "--csv") {
+            config.csv_path = value();
+        }
+        else if (arg == "--list") {
+            config.list = true;
+        }
+        else {
+            throw std::invalid_argument("unknown option " + arg);
+        }
+    }
+    return config;
+}
+
+static BenchResult summarize(const Benchmark &bench, int threads, std::vector<double> samples)
+{
+    BenchResult r {bench.name, bench.unit, bench.higher_is_better, threads, samples, 0, 0, 0, 0, 0};
+    std::sort(samples.begin(), samples.end());
+    std::size_t n = samples.size();
+    r.median = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+    r.min = samples.front();
+    r.max = samples.back();
+    for (double s : samples) {
+        r.mean += s;
+    }
+    r.mean /= n;
+    for (double s : samples) {
+        r.stddev += (s - r.mean) * (s - r.mean);
+    }
+    r.stddev = n > 1 ? std::sqrt(r.stddev / (n - 1)) : 0.0;
+    return r;
+}
+
+std::vector<BenchResult> run_benchmarks(const std::vector<Benchmark> &benchmarks, const BenchConfig &config)
+{
+    std::vector<BenchResult> results;
+    CpuTopology topo = read_cpu_topology();
+
+    std::cout << std::left << std::setw(28) << "benchmark" << std::right << std::setw(8) << "threads"
+              << std::setw(12) << "median" << std::setw(12) << "min" << std::setw(12) << "max"
+              << std::setw(10) << "stddev" << "  unit" << std::endl;
+
+    for (const Benchmark &bench : benchmarks) {
+        if (bench.name.find(config.filter) == std::string::npos) {
+            continue;
+        }
+        for (int threads : config.threads) {
+            BenchContext ctx(threads, config.pin ? plan_placement(topo, threads, Placement::scatter)
+                                                 : std::vector<int>(threads, -1));
+            for (int i = 0; i < config.warmup; ++i) {
+                bench.run(ctx);
+            }
+            std::vector<double> samples;
+            for (int i = 0; i < config.reps; ++i) {
+                samples.push_back(bench.run(ctx));
+            }
+
+            BenchResult r = summarize(bench, threads, samples);
+            std::cout << std::left << std::setw(28) << r.name << std::right << std::setw(8) << threads
+                      << std::setprecision(4) << std::setw(12) << r.median << std::setw(12) << r.min
+                      << std::setw(12) << r.max << std::setw(10) << r.stddev << "  " << r.unit << std::endl;
+            if (ctx.pin_failures.load() > 0) {
+                std::cerr << "warning: " << bench.name << " could not pin " << ctx.pin_failures.load()
+                          << " thread starts, those ran unpinned" << std::endl;
+            }
+            results.push_back(std::move(r));
+        }
+    }
+    return results;
+}
+
+static std::string utc_timestamp()
+{
+    std::time_t now = std::time(nullptr);
+    char text[32];
+    std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+    return text;
+}
+
+// Labels come from the command line and may hold quotes, backslashes or anything else
+static std::string json_string(const std::string &text)
+{
+    std::string out = "\"";
+    for (char c : text) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char code[8];
+                    std::snprintf(code, sizeof(code), "\\u%04x", c);
+                    out += code;
+                }
+                else {
+                    out += c;
+                }
+        }
+    }
+    return out + "\"";
+}
+
+// Quoted only when needed, a quote inside is doubled
+static std::string csv_field(const std::string &text)
+{
+    if (text.find_first_of(",\"\r\n") == std::string::npos) {
+        return text;
+    }
+    std::string out = "\"";
+    for (char c : text) {
+        out += c == '"' ? std::string("\"\"") : std::string(1, c);
+    }
+    return out + "\"";
+}
+
+bool write_bench_json(const std::string &path, const BenchConfig &config, const std::vector<BenchResult> &results)
+{
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << std::setprecision(9);
+    out << "{\n  \"label\": " << json_string(config.label) << ",\n"
+        << "  \"commit\": " << json_string(BENCH_GIT_COMMIT) << ",\n"
+        << "  \"timestamp\": \"" << utc_timestamp() << "\",\n"
+        << "  \"hardware_threads\": " << std::thread::hardware_concurrency() << ",\n"
+        << "  \"pinned\": " << (config.pin ? "true" : "false") << ",\n"
+        << "  \"warmup\": " << config.warmup << ",\n"
+        << "  \"reps\": " << config.reps << ",\n"
+        << "  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchResult &r = results[i];
+        out << (i ? ",\n" : "\n")
+            << "    {\"benchmark\": " << json_string(r.name) << ", \"unit\": " << json_string(r.unit)
+            << ", \"higher_is_better\": " << (r.higher_is_better ? "true" : "false") << ", \"threads\": " << r.threads
+            << ", \"median\": " << r.median << ", \"min\": " << r.min << ", \"max\": " << r.max
+            << ", \"mean\": " << r.mean << ", \"stddev\": " << r.stddev << ", \"samples\": [";
+        for (std::size_t s = 0; s < r.samples.size(); ++s) {
+            out << (s ? ", " : "") << r.samples[s];
+        }
+        out << "]}";
+    }
+    out << "\n  ]\n}\n";
+    return static_cast<bool>(out);
+}
+
+bool write_bench_csv(const std::string &path, const BenchConfig &config, const std::vector<BenchResult> &results)
+{
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+    out << std::setprecision(9);
+    out << "label,commit,benchmark,unit,threads,pinned,median,min,max,mean,stddev\n";
+    for (const BenchResult &r : results) {
+        out << csv_field(config.label) << ',' << BENCH_GIT_COMMIT << ',' << csv_field(r.name) << ','
+            << csv_field(r.unit) << ',' << r.threads << ','
+            << (config.pin ? 1 : 0) << ',' << r.median << ',' << r.min << ',' << r.max << ','
+            << r.mean << ',' << r.stddev << '\n';
+    }
+    return static_cast<bool>(out);
+}
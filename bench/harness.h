@@ -0,0 +1,118 @@
+#ifndef BENCH_HARNESS_H
+#define BENCH_HARNESS_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "launcher.h"
+
+/*
+ * Benchmark Harness
+ *
+ * - Each folder's main() prints its own table, in its own format
+ *      - Fine for reading, useless for comparing two commits
+ * - The harness runs every benchmark the same way
+ *      - Warmup runs, thrown away: first-touch page faults, cold caches, CPU clock ramping up
+ *      - Repetitions: we report the median, plus min/max/stddev to show the noise
+ *      - A sweep over thread counts
+ *      - Optional pinning, planned by thread_placement: scatter, one thread per core before any SMT sibling
+ *              - Only CPUs this process may run on, so it works under taskset and in containers
+ *              - Without it the scheduler moves threads around between repetitions
+ *      - Results as JSON and/or CSV, labelled with the git commit, so runs can be diffed
+ *
+ * - A benchmark is a function which is handed a BenchContext and returns one number
+ *      - e.g. million operations per second, or p99 latency in ns
+ *      - It starts its threads with ctx.run_threads(), which pins them and starts them together
+ *      */
+
+struct BenchConfig {
+    int warmup = 1;
+    int reps = 5;
+    std::vector<int> threads {1, 2, 4, 8};
+    bool pin = false;
+    std::string filter;     // only run benchmarks whose name contains this
+    std::string label;      // defaults to the git commit the harness was built from
+    std::string json_path;
+    std::string csv_path;
+    bool list = false;
+};
+
+// Throws std::invalid_argument for anything it does not understand
+BenchConfig parse_bench_args(int argc, char *argv[]);
+
+class BenchContext {
+private:
+    std::vector<int> cpus;      // one per thread, -1 for unpinned
+
+public:
+    const int threads;
+    // Threads the OS refused to pin, they ran wherever the scheduler put them
+    std::atomic<int> pin_failures {0};
+
+    BenchContext(int threads, std::vector<int> cpus) : cpus(std::move(cpus)), threads(threads) {}
+
+    // Runs body(index) on "threads" threads, released at the same moment
+    // Returns the seconds from the release until the last one has finished
+    template <typename Body>
+    double run_threads(Body body)
+    {
+        std::atomic<int> ready {0};
+        std::atomic<bool> go {false};
+        std::vector<std::thread> workers;
+
+        for (int t = 0; t < threads; ++t) {
+            workers.emplace_back([&, t] {
+                if (cpus[t] >= 0 && !pin_current_thread(cpus[t])) {
+                    pin_failures.fetch_add(1);
+                }
+                ready.fetch_add(1);
+                while (!go.load(std::memory_order_acquire)) {
+                    std::this_thread::yield();
+                }
+                body(t);
+            });
+        }
+        while (ready.load() != threads) {
+            std::this_thread::yield();
+        }
+        auto start = std::chrono::steady_clock::now();
+        go.store(true, std::memory_order_release);
+        for (auto &thr : workers) {
+            thr.join();
+        }
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+struct Benchmark {
+    std::string name;
+    std::string unit;               // e.g. "Mops/s", "ns"
+    bool higher_is_better;
+    std::function<double(BenchContext &)> run;
+};
+
+struct BenchResult {
+    std::string name;
+    std::string unit;
+    bool higher_is_better;
+    int threads;
+    std::vector<double> samples;
+    double median;
+    double min;
+    double max;
+    double mean;
+    double stddev;
+};
+
+std::vector<BenchResult> run_benchmarks(const std::vector<Benchmark> &benchmarks, const BenchConfig &config);
+
+// Returns false if the file could not be written
+bool write_bench_json(const std::string &path, const BenchConfig &config, const std::vector<BenchResult> &results);
+bool write_bench_csv(const std::string &path, const BenchConfig &config, const std::vector<BenchResult> &results);
+
+#endif //BENCH_HARNESS_H
@@ -0,0 +1,152 @@
+#include <iostream>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <stdexcept>
+
+#include "harness.h"
+#include "arena.h"
+#include "latency_histogram.h"
+#include "object_pool.h"
+#include "rng.h"
+#include "sharded_counter.h"
+
+/*
+ * The benchmarks
+ * - Every thread does the same amount of work, so perfect scaling keeps Mops/s growing with threads
+ * - Latency benchmarks report a percentile in ns
+ *
+ * Usage: bench [--threads 1,2,4,8] [--reps 5] [--warmup 1] [--pin] [--filter name]
+ *              [--label text] [--json file] [--csv file] [--list]
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr long ops_per_thread = 500'000;
+
+double mops(const BenchContext &ctx, double seconds)
+{
+    return ctx.threads * ops_per_thread / seconds / 1e6;
+}
+
+struct Payload {
+    long value;
+    char bytes[56];
+};
+
+std::vector<Benchmark> all_benchmarks()
+{
+    return {
+        {"atomic_counter", "Mops/s", true, [] (BenchContext &ctx) {
+            std::atomic<std::uint64_t> counter {0};
+            return mops(ctx, ctx.run_threads([&] (int) {
+                for (long i = 0; i < ops_per_thread; ++i) {
+                    counter.fetch_add(1, std::memory_order_relaxed);
+                }
+            }));
+        }},
+        {"sharded_counter", "Mops/s", true, [] (BenchContext &ctx) {
+            ShardedCounter counter;
+            return mops(ctx, ctx.run_threads([&] (int) {
+                for (long i = 0; i < ops_per_thread; ++i) {
+                    counter.increment();
+                }
+            }));
+        }},
+        {"mutex_lock_p99", "ns", false, [] (BenchContext &ctx) {
+            std::mutex mut;
+            long shared {0};
+            LatencyRecorder recorder;
+            ctx.run_threads([&] (int) {
+                for (long i = 0; i < ops_per_thread / 10; ++i) {
+                    auto start = bench_clock::now();
+                    std::lock_guard<std::mutex> lck_guard(mut);
+                    recorder.record(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count());
+                    ++shared;
+                }
+            });
+            return static_cast<double>(recorder.snapshot().percentile(0.99));
+        }},
+        {"new_delete", "Mops/s", true, [] (BenchContext &ctx) {
+            return mops(ctx, ctx.run_threads([&] (int) {
+                std::vector<Payload *> live(64);
+                for (long i = 0; i < ops_per_thread; i += 64) {
+                    for (auto &p : live) {
+                        p = new Payload;
+                    }
+                    for (auto &p : live) {
+                        delete p;
+                    }
+                }
+            }));
+        }},
+        {"object_pool", "Mops/s", true, [] (BenchContext &ctx) {
+            ObjectPool<Payload> pool;
+            return mops(ctx, ctx.run_threads([&] (int) {
+                std::vector<Payload *> live(64);
+                for (long i = 0; i < ops_per_thread; i += 64) {
+                    for (auto &p : live) {
+                        p = pool.create();
+                    }
+                    for (auto &p : live) {
+                        pool.destroy(p);
+                    }
+                }
+            }));
+        }},
+        {"arena_alloc", "Mops/s", true, [] (BenchContext &ctx) {
+            return mops(ctx, ctx.run_threads([&] (int) {
+                for (long i = 0; i < ops_per_thread; i += 64) {
+                    ArenaScope scope;
+                    for (int j = 0; j < 64; ++j) {
+                        thread_arena().make<Payload>();
+                    }
+                }
+            }));
+        }},
+        {"thread_rng", "Mops/s", true, [] (BenchContext &ctx) {
+            return mops(ctx, ctx.run_threads([&] (int) {
+                std::uint64_t sink {0};
+                for (long i = 0; i < ops_per_thread; ++i) {
+                    sink += thread_rng()();
+                }
+                volatile std::uint64_t keep = sink;
+                (void)keep;
+            }));
+        }},
+    };
+}
+
+int main(int argc, char *argv[]) {
+    BenchConfig config;
+    try {
+        config = parse_bench_args(argc, argv);
+    }
+    catch (std::exception &e) {
+        std::cerr << "bench: " << e.what() << std::endl;
+        return 1;
+    }
+
+    std::vector<Benchmark> benchmarks = all_benchmarks();
+    if (config.list) {
+        for (auto &bench : benchmarks) {
+            std::cout << bench.name << " (" << bench.unit << ")" << std::endl;
+        }
+        return 0;
+    }
+
+    std::vector<BenchResult> results = run_benchmarks(benchmarks, config);
+
+    if (!config.json_path.empty() && !write_bench_json(config.json_path, config, results)) {
+        std::cerr << "bench: could not write " << config.json_path << std::endl;
+        return 1;
+    }
+    if (!config.csv_path.empty() && !write_bench_csv(config.csv_path, config, results)) {
+        std::cerr << "bench: could not write " << config.csv_path << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,68 @@
+#ifndef CACHE_PADDING_CACHE_PADDED_H
+#define CACHE_PADDING_CACHE_PADDED_H
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+/*
+ * False Sharing
+ *
+ * - The CPU caches memory in lines, usually 64 bytes
+ *      - A core must own a line exclusively before it can write to it
+ * - Two variables in the same line, written by two threads on two cores
+ *      - Every write takes the line away from the other core
+ *      - The line "ping-pongs" between the caches
+ *      - The threads never touch each other's variable, but they run as if they shared it
+ *
+ * - In thread_synchronization
+ *      - update_progress, completed, download_complete, string_updated are bools next to each other
+ *      - The mutexes that protect them are right beside them as well
+ *      - Threads spinning on one mutex slow down threads using its neighbours
+ *
+ * - Fix: give each independently written variable a cache line of its own
+ *      - alignas(destructive_interference_size) on the variable
+ *      - or wrap it: CachePadded<std::atomic<int>> counter;
+ *
+ * - But data which is always used together, under the same mutex, should share a line
+ *      - e.g. a mutex, its flag and the data it protects
+ *      - Padding those apart only adds cache misses
+ *      */
+
+/*
+ * How far apart is far enough?
+ * - C++17 has std::hardware_destructive_interference_size
+ *      - GCC warns when it is used in a header, because its value can change with -mtune
+ *              and two files built with different flags would disagree about a struct's layout
+ * - So we fix the value ourselves
+ *      - x86: lines are 64 bytes, but the "spatial prefetcher" fetches lines in pairs, so use 128
+ *      - Apple M1 and some other ARM cores have 128-byte lines
+ *      */
+#if defined(__x86_64__) || defined(__i386__) || defined(__aarch64__) || defined(__powerpc64__)
+constexpr std::size_t destructive_interference_size = 128;
+#else
+constexpr std::size_t destructive_interference_size = 64;
+#endif
+
+// Size of one cache line, for data that should share a line
+constexpr std::size_t constructive_interference_size = 64;
+
+// A T alone on its own cache line(s)
+// The alignment also rounds sizeof(CachePadded<T>) up, so the next object starts on a new line
+template <typename T>
+struct alignas(destructive_interference_size) CachePadded {
+    T value;
+
+    // Not for a single CachePadded: a non-const one would pick this over the copy constructor
+    template <typename... Args,
+              typename = std::enable_if_t<!(sizeof...(Args) == 1
+                                            && std::conjunction_v<std::is_same<std::decay_t<Args>, CachePadded>...>)>>
+    explicit CachePadded(Args &&... args) : value(std::forward<Args>(args)...) {}
+
+    T &operator*() { return value; }
+    const T &operator*() const { return value; }
+    T *operator->() { return &value; }
+    const T *operator->() const { return &value; }
+};
+
+#endif //CACHE_PADDING_CACHE_PADDED_H
@@ -0,0 +1,118 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "cache_padded.h"
+
+/*
+ * The shared state of the download example in thread_synchronization,
+ * as laid out in memory
+ * - Everything is packed together: mutexes and flags that different threads hammer share lines
+ *      */
+struct PackedDownloadState {
+    std::mutex data_lock;
+    std::mutex print_mut;
+    bool string_updated = false;
+    bool download_complete = false;
+    bool update_progress = false;
+    bool completed = false;
+};
+
+/*
+ * Padded version
+ * - data_lock and the flags it protects stay together on one line
+ *      - They are always used together, by the thread holding the lock
+ * - print_mut gets a line of its own
+ *      - Any thread printing no longer disturbs threads waiting for data_lock
+ * - update_progress and completed are protected by other mutexes, so they move away too
+ *      */
+struct PaddedDownloadState {
+    struct alignas(destructive_interference_size) {
+        std::mutex data_lock;
+        bool string_updated = false;
+        bool download_complete = false;
+    } data;
+    CachePadded<std::mutex> print_mut;
+    CachePadded<bool> update_progress {false};
+    CachePadded<bool> completed {false};
+};
+
+template <typename State>
+void print_layout(const std::string &name)
+{
+    std::cout << name << ": sizeof " << sizeof(State) << " bytes, "
+              << (sizeof(State) + constructive_interference_size - 1) / constructive_interference_size
+              << " cache line(s)" << std::endl;
+}
+
+/*
+ * Benchmark
+ * - N threads, each increments its own counter, nothing is shared
+ * - Adjacent: the counters are an array of std::atomic<std::uint64_t>, 8 to a cache line
+ * - Padded: an array of CachePadded<std::atomic<std::uint64_t>>, one per line
+ * - Expect the adjacent version to slow down badly as soon as two threads run on different cores
+ *      - On a single core there is no second cache, so there is nothing to ping-pong
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename Counter>
+double increments_per_second(int threads, std::uint64_t increments)
+{
+    std::vector<Counter> counters(threads);
+    std::vector<std::thread> workers;
+
+    auto start = bench_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&counters, t, increments] {
+            auto &counter = counters[t];
+            for (std::uint64_t i = 0; i < increments; ++i) {
+                counter->fetch_add(1, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return threads * increments / seconds / 1e6;
+}
+
+// Same interface as CachePadded, but no padding
+template <typename T>
+struct Unpadded {
+    T value {};
+    T *operator->() { return &value; }
+};
+
+void benchmark(std::uint64_t increments)
+{
+    std::cout << "\nMillion increments per second (" << sizeof(Unpadded<std::atomic<std::uint64_t>>)
+              << " bytes vs " << sizeof(CachePadded<std::atomic<std::uint64_t>>) << " bytes per counter)" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "adjacent" << std::setw(14) << "padded" << std::endl;
+
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::cout << std::setw(8) << threads
+                  << std::setw(14) << increments_per_second<Unpadded<std::atomic<std::uint64_t>>>(threads, increments)
+                  << std::setw(14) << increments_per_second<CachePadded<std::atomic<std::uint64_t>>>(threads, increments)
+                  << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "destructive_interference_size = " << destructive_interference_size
+              << ", constructive_interference_size = " << constructive_interference_size << std::endl;
+    print_layout<PackedDownloadState>("PackedDownloadState");
+    print_layout<PaddedDownloadState>("PaddedDownloadState");
+
+    std::uint64_t increments = argc > 1 ? std::stoull(argv[1]) : 20'000'000;
+    benchmark(increments);
+
+    return 0;
+}
@@ -0,0 +1,140 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+
+#include "trace.h"
+
+using namespace std::literals;
+
+/*
+ * fetch_data(), progress_bar() and process_data() from thread_synchronization, traced
+ * - The sleeps are 200ms instead of 2s
+ * - Run it, then load the trace file into https://ui.perfetto.dev
+ *      - "fetch block" shows when the fetcher is busy
+ *      - "wait data_lock" shows time blocked on the mutex
+ *      - "wait string_updated" and "wait download_complete" show time blocked on the condition variable
+ *      */
+
+std::string downloaded_data;
+std::mutex data_lock;
+
+std::mutex print_mut;
+std::condition_variable download_condition_variable;
+bool string_updated = false;
+bool download_complete = false;
+
+void fetch_data()
+{
+    trace_thread_name("fetch_data");
+    TRACE_SCOPE("fetch_data");
+
+    for (int i = 0; i < 5; ++i) {
+        {
+            TRACE_SCOPE("download");
+            std::this_thread::sleep_for(200ms);
+        }
+
+        std::unique_lock<std::mutex> lock = traced_lock(data_lock, "wait data_lock");
+        TRACE_SCOPE("fetch block");
+        downloaded_data += "Block" + std::to_string(i+1);
+        string_updated = true;
+        trace_instant("notify_one");
+        download_condition_variable.notify_one();
+    }
+
+    std::unique_lock<std::mutex> final_lock = traced_lock(data_lock, "wait data_lock");
+    download_complete = true;
+    trace_instant("notify_all");
+    download_condition_variable.notify_all();
+}
+
+void progress_bar()
+{
+    trace_thread_name("progress_bar");
+    TRACE_SCOPE("progress_bar");
+    size_t len = 0;
+
+    while (true)
+    {
+        std::unique_lock<std::mutex> uniq_lck = traced_lock(data_lock, "wait data_lock");
+        traced_wait_for(download_condition_variable, uniq_lck, 2s, [] {return string_updated;}, "wait string_updated");
+        len = downloaded_data.size();
+        string_updated = false;
+        uniq_lck.unlock();
+        {
+            std::unique_lock<std::mutex> print_lock = traced_lock(print_mut, "wait print_mut");
+            TRACE_SCOPE("print progress");
+            std::cout << "Received " << len << " bytes so far....." << std::endl;
+        }
+
+        std::unique_lock<std::mutex> final_uniq = traced_lock(data_lock, "wait data_lock");
+        if (traced_wait_for(download_condition_variable, final_uniq, 10ms, [] {return download_complete;},
+                            "wait download_complete")) {
+            break;
+        }
+    }
+}
+
+void process_data()
+{
+    trace_thread_name("process_data");
+    std::unique_lock<std::mutex> uniq_lck = traced_lock(data_lock, "wait data_lock");
+    traced_wait(download_condition_variable, uniq_lck, [] {return download_complete;}, "wait download_complete");
+
+    TRACE_SCOPE("process data");
+    std::unique_lock<std::mutex> print_lock = traced_lock(print_mut, "wait print_mut");
+    std::cout << "Processing data: " << downloaded_data << std::endl;
+}
+
+/*
+ * What does a TraceScope cost?
+ * - Off: one relaxed load and a branch per scope
+ * - On: two rdtsc and two stores into the thread's buffer
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+double ns_per_scope(int scopes)
+{
+    auto start = bench_clock::now();
+    for (int i = 0; i < scopes; ++i) {
+        TRACE_SCOPE("overhead");
+    }
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / scopes;
+}
+
+int main(int argc, char *argv[]) {
+    std::string path = argc > 1 ? argv[1] : "trace.json";
+    // Half of a thread's buffer: one scope is two events
+    int scopes = argc > 2 ? std::stoi(argv[2]) : static_cast<int>(trace_buffer_events / 4);
+
+    double disabled = ns_per_scope(scopes);
+
+    trace_enable(path);
+    trace_thread_name("main");
+
+    std::thread fetcher(fetch_data);
+    std::thread prog(progress_bar);
+    std::thread processor(process_data);
+
+    fetcher.join();
+    prog.join();
+    processor.join();
+
+    double enabled {0};
+    std::thread bench([&] {
+        trace_thread_name("overhead benchmark");
+        // The first event allocates the thread's event array, keep that out of the timed loop
+        trace_instant("warm up");
+        enabled = ns_per_scope(scopes);
+    });
+    bench.join();
+
+    std::cout << "\nTraceScope cost: " << disabled << " ns with tracing off, " << enabled << " ns with tracing on" << std::endl;
+    std::cout << "Trace is written to " << path << " when the program exits" << std::endl;
+
+    return 0;
+}
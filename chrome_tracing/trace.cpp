@@ -0,0 +1,167 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <vector>
+
+struct TraceRegistry {
+    std::mutex mut;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;
+    std::vector<TraceBuffer *> retired;     // threads gone, freed after the next trace_write()
+    std::uint64_t next_id = 1;              // the "tid" in the trace, not reused when buffers are freed
+    std::string exit_path;
+    bool exit_handler_installed = false;
+
+    // Time zero of the trace, as ticks and as steady_clock, to calibrate the TSC
+    bool started = false;
+    std::uint64_t start_ticks = 0;
+    std::chrono::steady_clock::time_point start_time;
+};
+
+// Never destroyed: threads may still be recording while static destructors run
+static TraceRegistry &registry()
+{
+    static TraceRegistry *reg = new TraceRegistry;
+    return *reg;
+}
+
+static void write_at_exit()
+{
+    TraceRegistry &reg = registry();
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lck_guard(reg.mut);
+        path = reg.exit_path;
+    }
+    trace_disable();
+    trace_write(path);
+}
+
+static void write_json_string(std::ostream &out, const char *s)
+{
+    out << '"';
+    for (; s && *s; ++s) {
+        switch (*s) {
+            case '"': out << "\\\""; break;
+            case '\\': out << "\\\\"; break;
+            case '\n': out << "\\n"; break;
+            default: out << *s;
+        }
+    }
+    out << '"';
+}
+
+TraceBuffer *register_trace_buffer()
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    reg.buffers.push_back(std::make_unique<TraceBuffer>(reg.next_id++));
+    return reg.buffers.back().get();
+}
+
+void retire_trace_buffer(TraceBuffer *buffer)
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    reg.retired.push_back(buffer);
+}
+
+void trace_enable(const std::string &path)
+{
+    TraceRegistry &reg = registry();
+    {
+        std::lock_guard<std::mutex> lck_guard(reg.mut);
+        reg.exit_path = path;
+        if (!reg.started) {
+            reg.started = true;
+            reg.start_time = std::chrono::steady_clock::now();
+            reg.start_ticks = trace_ticks();
+        }
+        if (!reg.exit_handler_installed) {
+            reg.exit_handler_installed = true;
+            std::atexit(write_at_exit);
+        }
+    }
+    trace_enabled().store(true, std::memory_order_relaxed);
+}
+
+void trace_disable()
+{
+    trace_enabled().store(false, std::memory_order_relaxed);
+}
+
+bool trace_write(const std::string &path)
+{
+    TraceRegistry &reg = registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    if (!reg.started) {
+        return false;
+    }
+
+    std::ofstream out(path);
+    if (!out) {
+        return false;
+    }
+
+    // Ticks per microsecond, measured over the whole trace
+    std::uint64_t end_ticks = trace_ticks();
+    double elapsed_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - reg.start_time).count();
+    double ticks_per_us = elapsed_us > 0 ? (end_ticks - reg.start_ticks) / elapsed_us : 1000.0;
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+    out.precision(3);
+    out << std::fixed;
+    bool first = true;
+    auto separator = [&] {
+        if (!first) {
+            out << ",\n";
+        }
+        first = false;
+    };
+
+    for (auto &buffer : reg.buffers) {
+        if (const char *name = buffer->thread_name()) {
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buffer->id() << ",\"args\":{\"name\":";
+            write_json_string(out, name);
+            out << "}}";
+        }
+        if (std::size_t dropped = buffer->dropped_events()) {
+            separator();
+            out << "{\"ph\":\"M\",\"name\":\"dropped_events\",\"pid\":1,\"tid\":" << buffer->id()
+                << ",\"args\":{\"count\":" << dropped << "}}";
+        }
+
+        std::size_t count = buffer->size();
+        for (std::size_t i = 0; i < count; ++i) {
+            const TraceEvent &event = (*buffer)[i];
+            separator();
+            out << "{\"ph\":\"" << event.phase << "\",\"name\":";
+            write_json_string(out, event.name);
+            out << ",\"cat\":";
+            write_json_string(out, event.category);
+            // Another core's TSC may be a few ticks behind
+            std::uint64_t ticks = event.ticks > reg.start_ticks ? event.ticks - reg.start_ticks : 0;
+            out << ",\"ts\":" << ticks / ticks_per_us
+                << ",\"pid\":1,\"tid\":" << buffer->id();
+            if (event.phase == 'i') {
+                out << ",\"s\":\"t\"";
+            }
+            out << "}";
+        }
+    }
+    out << "\n]}\n";
+    if (!out) {
+        return false;
+    }
+
+    // Nobody records into these any more, and their events are in the file
+    for (TraceBuffer *buffer : reg.retired) {
+        reg.buffers.erase(std::find_if(reg.buffers.begin(), reg.buffers.end(), [buffer] (const auto &b) {
+            return b.get() == buffer;
+        }));
+    }
+    reg.retired.clear();
+    return true;
+}
@@ -0,0 +1,237 @@
+#ifndef CHROME_TRACING_TRACE_H
+#define CHROME_TRACING_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*
+ * Tracing Thread Activity
+ *
+ * - Printing "waiting for data...." tells us what a thread is about to do, not how long it took
+ * - A trace records timestamped events from every thread
+ *      - Begin/end of a scope: "fetch block", "process data"
+ *      - Time spent waiting for a mutex
+ *      - Time spent waiting on a condition variable
+ * - Written as Chrome trace JSON: open it in chrome://tracing or https://ui.perfetto.dev
+ *      - One row per thread, so we can see who is running and who is blocked
+ *
+ * - Recording must be cheap, or the trace changes the timing it is measuring
+ *      - Each thread has its own buffer, only that thread writes to it
+ *              - No lock, no shared cache line, just a store and a counter bump
+ *              - The count is published with a release store, so the writer sees complete events
+ *      - Timestamps come from the TSC (rdtsc): a few nanoseconds, no system call
+ *              - Converted to microseconds when the trace is written
+ *              - Needs an invariant TSC, which every x86 CPU of the last 15 years has
+ *              - Other platforms use steady_clock
+ *      - Names are const char *, they must be string literals (or live until the trace is written)
+ *      - When tracing is off, every call is one relaxed load and a branch
+ *
+ * - A thread's buffer (2MB) is only allocated once it records its first event
+ *      - Threads which never record while tracing is on cost a few bytes, even if they were named
+ *      - Once a thread has exited and its events have been written, the buffer is freed
+ *
+ * - When a thread's buffer is full, further events are dropped and counted
+ *      - Room for the end of every open scope is kept, so a begin is never written without its end
+ *      - A scope which does not fit is dropped whole, begin and end
+ *      */
+
+constexpr std::size_t trace_buffer_events = 1 << 16;
+
+struct TraceEvent {
+    const char *name;
+    const char *category;
+    std::uint64_t ticks;
+    char phase;     // 'B' begin, 'E' end, 'i' instant, as in the Chrome format
+};
+
+class TraceBuffer {
+private:
+    // Allocated by the owner on its first event, other threads only look at it once count > 0
+    std::unique_ptr<TraceEvent[]> events;
+    std::atomic<std::size_t> count {0};
+    std::atomic<std::size_t> dropped {0};
+    std::atomic<const char *> name {nullptr};
+    std::uint64_t thread_id;
+    std::size_t open_scopes = 0;    // begins without their end yet, only used by the owner
+
+public:
+    explicit TraceBuffer(std::uint64_t thread_id) : thread_id(thread_id) {}
+
+    // Only called by the owning thread
+    // Returns false if the event was dropped: for a 'B', do not record its 'E' either
+    bool record(char phase, const char *event_name, const char *category, std::uint64_t ticks)
+    {
+        std::size_t i = count.load(std::memory_order_relaxed);
+        // The slots at the end are kept for the 'E' of every open scope, and of this one
+        std::size_t needed = phase == 'E' ? 1 : phase == 'B' ? open_scopes + 2 : open_scopes + 1;
+        if (trace_buffer_events - i < needed) {
+            dropped.fetch_add(phase == 'B' ? 2 : 1, std::memory_order_relaxed);
+            return false;
+        }
+        if (!events) {
+            events.reset(new TraceEvent[trace_buffer_events]);
+        }
+        events[i] = TraceEvent{event_name, category, ticks, phase};
+        if (phase == 'B') {
+            ++open_scopes;
+        }
+        else if (phase == 'E' && open_scopes > 0) {
+            --open_scopes;
+        }
+        count.store(i + 1, std::memory_order_release);
+        return true;
+    }
+
+    void set_name(const char *thread_name) { name.store(thread_name, std::memory_order_release); }
+
+    // Safe to call from any thread while the owner is still recording
+    std::size_t size() const { return count.load(std::memory_order_acquire); }
+    const TraceEvent &operator[](std::size_t i) const { return events[i]; }
+    std::size_t dropped_events() const { return dropped.load(std::memory_order_relaxed); }
+    const char *thread_name() const { return name.load(std::memory_order_acquire); }
+    std::uint64_t id() const { return thread_id; }
+};
+
+inline std::uint64_t trace_ticks()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+inline std::atomic<bool> &trace_enabled()
+{
+    static std::atomic<bool> enabled {false};
+    return enabled;
+}
+
+// Creates the calling thread's buffer and adds it to the list which is written out
+TraceBuffer *register_trace_buffer();
+// The thread is exiting: the buffer is freed once its events have been written
+void retire_trace_buffer(TraceBuffer *buffer);
+
+class ThreadTraceBuffer {
+public:
+    TraceBuffer *const buffer = register_trace_buffer();
+
+    ~ThreadTraceBuffer() { retire_trace_buffer(buffer); }
+};
+
+inline TraceBuffer &thread_trace_buffer()
+{
+    thread_local ThreadTraceBuffer thread_buffer;
+    return *thread_buffer.buffer;
+}
+
+// Start recording, and write the trace to "path" when the program exits
+void trace_enable(const std::string &path);
+
+// Stop recording (the events so far are kept)
+void trace_disable();
+
+// Write everything recorded so far, returns false if the file could not be opened
+// The buffers of threads which have exited are freed afterwards, their events are not written again
+bool trace_write(const std::string &path);
+
+// Name for the calling thread's row in the viewer
+inline void trace_thread_name(const char *name)
+{
+    thread_trace_buffer().set_name(name);
+}
+
+inline void trace_event(char phase, const char *name, const char *category)
+{
+    if (trace_enabled().load(std::memory_order_relaxed)) {
+        thread_trace_buffer().record(phase, name, category, trace_ticks());
+    }
+}
+
+inline void trace_instant(const char *name, const char *category = "event")
+{
+    trace_event('i', name, category);
+}
+
+// Records a begin event now and the matching end event when it goes out of scope
+class TraceScope {
+private:
+    const char *name;
+    const char *category;
+    bool recorded;
+
+public:
+    explicit TraceScope(const char *name, const char *category = "scope")
+        : name(name), category(category), recorded(trace_enabled().load(std::memory_order_relaxed))
+    {
+        if (recorded) {
+            recorded = thread_trace_buffer().record('B', name, category, trace_ticks());
+        }
+    }
+
+    ~TraceScope()
+    {
+        // Even if tracing was switched off in between, so begin and end always match
+        // The buffer kept room for it
+        if (recorded) {
+            thread_trace_buffer().record('E', name, category, trace_ticks());
+        }
+    }
+
+    TraceScope(const TraceScope &source) = delete;
+    TraceScope &operator=(const TraceScope &source) = delete;
+};
+
+#define TRACE_CONCAT_IMPL(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
+
+/*
+ * Lock and condition variable waits
+ * - Only a wait which actually blocks is recorded
+ *      - An uncontended lock or an already-true predicate costs nothing extra
+ * - The event covers the time between asking for the lock and getting it
+ *      */
+template <typename Mutex>
+std::unique_lock<Mutex> traced_lock(Mutex &mut, const char *name)
+{
+    if (mut.try_lock()) {
+        return std::unique_lock<Mutex>(mut, std::adopt_lock);
+    }
+    TraceScope wait(name, "lock wait");
+    return std::unique_lock<Mutex>(mut);
+}
+
+template <typename Predicate>
+void traced_wait(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, Predicate pred, const char *name)
+{
+    if (pred()) {
+        return;
+    }
+    TraceScope wait(name, "cv wait");
+    cv.wait(lock, pred);
+}
+
+template <typename Rep, typename Period, typename Predicate>
+bool traced_wait_for(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                     const std::chrono::duration<Rep, Period> &timeout, Predicate pred, const char *name)
+{
+    if (pred()) {
+        return true;
+    }
+    TraceScope wait(name, "cv wait");
+    return cv.wait_for(lock, timeout, pred);
+}
+
+#endif //CHROME_TRACING_TRACE_H
@@ -0,0 +1,249 @@
+#ifndef COMPLETION_PRIMITIVES_COMPLETION_H
+#define COMPLETION_PRIMITIVES_COMPLETION_H
+
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "futex.h"
+
+/*
+ * Completion Primitives
+ * - In thread_synchronization we signal "the download is complete" with
+ *      - A bool flag
+ *      - A mutex to protect the flag
+ *      - A condition variable to wait on
+ * - Every signal and every check locks the mutex, even when nobody is waiting
+ *
+ * - Latch
+ *      - A counter which threads count down
+ *      - Threads can wait until it reaches zero
+ *      - Single use, it never goes back up
+ * - Barrier
+ *      - A group of threads wait for each other at the end of each phase
+ *      - The last thread to arrive runs a completion function, then releases everyone
+ *              - If the completion throws, everyone is still released and the exception
+ *                      comes out of the last thread's arrive_and_wait()
+ *      - Reusable, one phase after another
+ * - OneShot<T>
+ *      - A value which is set once by one thread
+ *      - Any number of threads can wait for it
+ *      - Like std::promise/std::future, without the shared state allocation and the mutex
+ *
+ * - All three are a few atomic operations on the fast path
+ *      - A waiter spins for a short while first, then sleeps on a futex
+ *      - A signaller only makes the wake system call if somebody is asleep
+ *      */
+
+// How many times a waiter checks before going to sleep
+constexpr int completion_spin_limit = 100;
+
+class Latch {
+private:
+    std::atomic<std::uint32_t> count;
+    std::atomic<std::uint32_t> sleepers {0};
+
+public:
+    explicit Latch(std::uint32_t expected) : count(expected) {}
+
+    Latch(const Latch &source) = delete;
+    Latch &operator=(const Latch &source) = delete;
+
+    void count_down(std::uint32_t n = 1)
+    {
+        // The release publishes everything this thread did before counting down
+        if (count.fetch_sub(n, std::memory_order_seq_cst) == n) {
+            // Pairs with the seq_cst increment in wait()
+            // Either we see the sleeper, or the sleeper sees count == 0
+            if (sleepers.load(std::memory_order_seq_cst) != 0) {
+                futex_wake_all(count);
+            }
+        }
+    }
+
+    bool try_wait() const
+    {
+        return count.load(std::memory_order_acquire) == 0;
+    }
+
+    void wait()
+    {
+        for (int i {0}; i < completion_spin_limit; ++i) {
+            if (try_wait()) {
+                return;
+            }
+            cpu_relax();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::uint32_t c = count.load(std::memory_order_seq_cst);
+        while (c != 0) {
+            futex_wait(count, c);
+            c = count.load(std::memory_order_acquire);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    void arrive_and_wait(std::uint32_t n = 1)
+    {
+        count_down(n);
+        wait();
+    }
+};
+
+class Barrier {
+private:
+    const std::uint32_t expected;
+    std::atomic<std::uint32_t> remaining;
+
+    // Bumped by the last thread of every phase, the waiters sleep on it
+    std::atomic<std::uint32_t> phase {0};
+    std::atomic<std::uint32_t> sleepers {0};
+
+    std::function<void()> completion;
+
+public:
+    explicit Barrier(std::uint32_t expected, std::function<void()> completion = {})
+        : expected(expected), remaining(expected), completion(std::move(completion)) {}
+
+    Barrier(const Barrier &source) = delete;
+    Barrier &operator=(const Barrier &source) = delete;
+
+    void arrive_and_wait()
+    {
+        // Read the phase before arriving, otherwise we could miss the flip
+        const std::uint32_t current = phase.load(std::memory_order_acquire);
+
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            // Last thread in
+            // Everyone else is waiting, so the completion runs without any lock
+            // If it throws, the phase still has to flip, or the others sleep forever
+            std::exception_ptr error;
+            if (completion) {
+                try {
+                    completion();
+                }
+                catch (...) {
+                    error = std::current_exception();
+                }
+            }
+            remaining.store(expected, std::memory_order_relaxed);
+
+            // The release publishes the reset count and the completion's work
+            phase.fetch_add(1, std::memory_order_seq_cst);
+            if (sleepers.load(std::memory_order_seq_cst) != 0) {
+                futex_wake_all(phase);
+            }
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return;
+        }
+
+        for (int i {0}; i < completion_spin_limit; ++i) {
+            if (phase.load(std::memory_order_acquire) != current) {
+                return;
+            }
+            cpu_relax();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        while (phase.load(std::memory_order_seq_cst) == current) {
+            futex_wait(phase, current);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    std::uint32_t current_phase() const
+    {
+        return phase.load(std::memory_order_acquire);
+    }
+};
+
+template <typename T>
+class OneShot {
+private:
+    enum : std::uint32_t { empty = 0, writing = 1, ready = 2 };
+
+    std::atomic<std::uint32_t> state {empty};
+    std::atomic<std::uint32_t> sleepers {0};
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *value_ptr()
+    {
+        return std::launder(reinterpret_cast<T *>(storage));
+    }
+
+public:
+    OneShot() = default;
+
+    OneShot(const OneShot &source) = delete;
+    OneShot &operator=(const OneShot &source) = delete;
+
+    ~OneShot()
+    {
+        if (state.load(std::memory_order_acquire) == ready) {
+            value_ptr()->~T();
+        }
+    }
+
+    template <typename... Args>
+    void set(Args &&... args)
+    {
+        std::uint32_t expected_state = empty;
+        if (!state.compare_exchange_strong(expected_state, writing, std::memory_order_acquire)) {
+            throw std::logic_error("OneShot value has already been set");
+        }
+
+        try {
+            new (storage) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            // Let somebody else try again
+            state.store(empty, std::memory_order_release);
+            throw;
+        }
+
+        state.store(ready, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) != 0) {
+            futex_wake_all(state);
+        }
+    }
+
+    bool is_ready() const
+    {
+        return state.load(std::memory_order_acquire) == ready;
+    }
+
+    // Returns nullptr if the value has not been set yet
+    const T *try_get()
+    {
+        return is_ready() ? value_ptr() : nullptr;
+    }
+
+    const T &wait()
+    {
+        for (int i {0}; i < completion_spin_limit; ++i) {
+            if (is_ready()) {
+                return *value_ptr();
+            }
+            cpu_relax();
+        }
+
+        sleepers.fetch_add(1, std::memory_order_seq_cst);
+        std::uint32_t s = state.load(std::memory_order_seq_cst);
+        while (s != ready) {
+            futex_wait(state, s);
+            s = state.load(std::memory_order_acquire);
+        }
+        sleepers.fetch_sub(1, std::memory_order_relaxed);
+        return *value_ptr();
+    }
+};
+
+#endif //COMPLETION_PRIMITIVES_COMPLETION_H
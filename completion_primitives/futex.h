@@ -0,0 +1,78 @@
+#ifndef COMPLETION_PRIMITIVES_FUTEX_H
+#define COMPLETION_PRIMITIVES_FUTEX_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Futex
+ * - "Fast Userspace muTEX"
+ * - A 32-bit word in our own memory which the kernel can put threads to sleep on
+ *      - futex_wait(word, expected) sleeps only if the word still holds "expected"
+ *      - futex_wake(word) wakes threads sleeping on the word
+ * - The check and the sleep are atomic inside the kernel
+ *      - A wake between our last load and the sleep cannot be lost
+ *      - If the word has already changed, the wait returns straight away
+ * - No mutex, no condition variable
+ *      - The fast path is a plain atomic operation in user space
+ *      - We only enter the kernel when a thread really has to sleep
+ *      */
+
+/*
+ * - std::atomic<T>::wait()/notify_all() do the same job, but they are C++20
+ * - Our projects are built as C++17, so we make the system call ourselves
+ * - Other platforms fall back to yielding until the word changes
+ *      */
+
+static_assert(sizeof(std::atomic<std::uint32_t>) == sizeof(std::uint32_t),
+              "futex word must have the same layout as a plain uint32_t");
+
+inline void futex_wait(std::atomic<std::uint32_t> &word, std::uint32_t expected)
+{
+#ifdef __linux__
+    // Spurious returns (EINTR, EAGAIN) are fine, every caller re-checks the word in a loop
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+#else
+    while (word.load(std::memory_order_acquire) == expected) {
+        std::this_thread::yield();
+    }
+#endif
+}
+
+inline void futex_wake_one(std::atomic<std::uint32_t> &word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+inline void futex_wake_all(std::atomic<std::uint32_t> &word)
+{
+#ifdef __linux__
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&word), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)word;
+#endif
+}
+
+// Tell the CPU we are in a spin loop (saves power, helps the sibling hyperthread)
+inline void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+#endif //COMPLETION_PRIMITIVES_FUTEX_H
@@ -0,0 +1,179 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+#include <atomic>
+#include <memory>
+
+#include "completion.h"
+#include "latency_histogram.h"
+
+using namespace std::literals;
+
+/*
+ * The fetch/process example again
+ * - One thread fetches the data
+ * - Several worker threads process it in stages
+ * - Another thread waits for the final result
+ *
+ * - OneShot<std::string> hands the finished download to the workers
+ * - A Barrier keeps the workers in step, its completion function reports each stage
+ * - A Latch tells main() that every worker has finished
+ *      */
+
+std::mutex print_mut;
+
+void fetch_data(OneShot<std::string> &download)
+{
+    std::string data;
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(50ms);
+        data += "Block" + std::to_string(i+1);
+        {
+            std::lock_guard<std::mutex> print(print_mut);
+            std::cout << "Fetched: " << data << std::endl;
+        }
+    }
+    // No flag, no mutex, no condition variable
+    download.set(std::move(data));
+}
+
+void process_data(int id, OneShot<std::string> &download, Barrier &stage_barrier, Latch &finished)
+{
+    const std::string &data = download.wait();
+
+    for (int stage = 0; stage < 3; ++stage) {
+        {
+            std::lock_guard<std::mutex> print(print_mut);
+            std::cout << "Worker " << id << " processing " << data.size() << " bytes, stage " << stage << std::endl;
+        }
+        stage_barrier.arrive_and_wait();
+    }
+    finished.count_down();
+}
+
+/*
+ * Signal-to-wake latency
+ * - The waiter announces that it is about to block
+ * - The signaller gives it time to fall asleep, reads the clock, then signals
+ * - The waiter reads the clock as soon as it wakes up
+ * - The difference is the cost of getting a sleeping thread running again
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename Wait, typename Signal>
+LatencyHistogram measure_wake_latency(int rounds, Wait wait, Signal signal)
+{
+    LatencyHistogram latency;
+    std::vector<bench_clock::time_point> sent(rounds);
+    std::atomic<int> about_to_wait {-1};
+
+    std::thread waiter([&] {
+        for (int i = 0; i < rounds; ++i) {
+            about_to_wait.store(i, std::memory_order_release);
+            wait(i);
+            auto woke = bench_clock::now();
+            latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(woke - sent[i]).count());
+        }
+    });
+
+    for (int i = 0; i < rounds; ++i) {
+        while (about_to_wait.load(std::memory_order_acquire) != i) {
+            std::this_thread::yield();
+        }
+        // Long enough for the waiter to give up spinning and sleep in the kernel
+        std::this_thread::sleep_for(50us);
+        sent[i] = bench_clock::now();
+        signal(i);
+    }
+    waiter.join();
+    return latency;
+}
+
+void benchmark_wake_latency(int rounds)
+{
+    std::cout << "\nSignal-to-wake latency over " << rounds << " rounds" << std::endl;
+    LatencyHistogram::print_summary_header(std::cout);
+
+    {
+        // The usual mutex + flag + condition variable
+        std::mutex m;
+        std::condition_variable cv;
+        int signalled {-1};
+        measure_wake_latency(rounds,
+            [&] (int i) {
+                std::unique_lock<std::mutex> lck(m);
+                cv.wait(lck, [&] {return signalled == i;});
+            },
+            [&] (int i) {
+                {
+                    std::lock_guard<std::mutex> lck(m);
+                    signalled = i;
+                }
+                cv.notify_one();
+            }).print_summary(std::cout, "std::condition_variable");
+    }
+
+    {
+        // Latches are single use, so one per round
+        std::vector<std::unique_ptr<Latch>> latches;
+        for (int i = 0; i < rounds; ++i) {
+            latches.push_back(std::make_unique<Latch>(1));
+        }
+        measure_wake_latency(rounds,
+            [&] (int i) {latches[i]->wait();},
+            [&] (int i) {latches[i]->count_down();}).print_summary(std::cout, "Latch");
+    }
+
+    {
+        std::vector<std::unique_ptr<OneShot<int>>> slots;
+        for (int i = 0; i < rounds; ++i) {
+            slots.push_back(std::make_unique<OneShot<int>>());
+        }
+        measure_wake_latency(rounds,
+            [&] (int i) {slots[i]->wait();},
+            [&] (int i) {slots[i]->set(i);}).print_summary(std::cout, "OneShot<int>");
+    }
+
+    {
+        // Two parties, the signaller arriving completes the phase
+        Barrier barrier(2);
+        measure_wake_latency(rounds,
+            [&] (int) {barrier.arrive_and_wait();},
+            [&] (int) {barrier.arrive_and_wait();}).print_summary(std::cout, "Barrier");
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const int workers = 3;
+
+    OneShot<std::string> download;
+    Barrier stage_barrier(workers, [stage = 0] () mutable {
+        std::lock_guard<std::mutex> print(print_mut);
+        std::cout << "All workers have finished stage " << stage++ << std::endl;
+    });
+    Latch finished(workers);
+
+    std::thread fetcher(fetch_data, std::ref(download));
+    std::vector<std::thread> processors;
+    for (int i = 0; i < workers; ++i) {
+        processors.emplace_back(process_data, i, std::ref(download), std::ref(stage_barrier), std::ref(finished));
+    }
+
+    finished.wait();
+    std::cout << "Processing complete" << std::endl;
+
+    fetcher.join();
+    for (auto &thr : processors) {
+        thr.join();
+    }
+
+    int rounds = argc > 1 ? std::stoi(argv[1]) : 2000;
+    benchmark_wake_latency(rounds);
+
+    return 0;
+}
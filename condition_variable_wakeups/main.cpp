@@ -0,0 +1,202 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+using namespace std::literals;
+
+/*
+ * Measuring Condition Variable Wakeups
+ *
+ * - In thread_synchronization
+ *      - reader() calls cond_var.wait(uniq_lck) without a predicate
+ *              - If writer() notifies before reader() starts waiting, the notification is lost
+ *              - If the wait returns spuriously, reader() carries on as if it had been notified
+ *      - reader_with_condition_variable() waits on cond_var
+ *              - but writer_with_condition_variable() notifies cond_variable
+ *              - Every notification is lost, the reader only wakes up by accident
+ *
+ * - This harness counts what actually happens
+ *      - A notifier thread posts one item per round and notifies
+ *      - N waiter threads wait for items using a plain wait(), no predicate
+ *      - Every wakeup is timestamped and sorted into one of:
+ *              - useful   : the waiter woke up and took the item
+ *              - futile   : the waiter was notified, but another waiter took the item first
+ *              - spurious : the wait returned but nobody had notified since it started waiting
+ *      - A lost wakeup is a round where nobody picks up the item before the timeout
+ *      */
+
+/*
+ * Two protocols
+ * - correct
+ *      - Waiters check for an item under the lock before calling wait()
+ *      - The notifier only posts once every waiter is asleep
+ *      - This is what wait(lock, predicate) does for us
+ * - naive
+ *      - Waiters call wait() straight away, like reader()
+ *      - The notifier does not care whether anyone is waiting
+ *      - Notifications that arrive while a waiter is busy are simply dropped
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+enum class Notify { one, all };
+enum class Protocol { correct, naive };
+
+struct WakeupReport {
+    LatencyHistogram latency;
+    std::uint64_t useful {0};
+    std::uint64_t futile {0};
+    std::uint64_t spurious {0};
+    std::uint64_t lost {0};
+};
+
+WakeupReport run_wakeup_test(int waiters, int rounds, Notify notify, Protocol protocol)
+{
+    std::mutex mut;
+    std::condition_variable cond_var;
+
+    // Everything below is protected by mut
+    std::uint64_t posted {0};           // items posted by the notifier
+    std::uint64_t consumed {0};         // items taken by the waiters
+    std::uint64_t notify_count {0};     // number of notify calls so far
+    bench_clock::time_point notify_time;
+    int sleeping {0};                   // waiters currently inside wait()
+    bool done = false;
+    WakeupReport report;
+
+    auto waiter = [&] () {
+        std::unique_lock<std::mutex> uniq_lck(mut);
+        while (!done) {
+            if (protocol == Protocol::correct && posted > consumed) {
+                ++consumed;
+                continue;
+            }
+
+            std::uint64_t seen_notifies = notify_count;
+            ++sleeping;
+            cond_var.wait(uniq_lck);
+            --sleeping;
+            auto woke = bench_clock::now();
+
+            if (done) {
+                break;
+            }
+            if (notify_count == seen_notifies) {
+                ++report.spurious;
+                continue;
+            }
+            report.latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(woke - notify_time).count());
+            if (posted > consumed) {
+                ++consumed;
+                ++report.useful;
+            }
+            else {
+                ++report.futile;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < waiters; ++i) {
+        threads.emplace_back(waiter);
+    }
+
+    for (int round = 0; round < rounds; ++round) {
+        std::unique_lock<std::mutex> uniq_lck(mut);
+        if (protocol == Protocol::correct) {
+            // Wait until everyone is asleep, so every round measures a real wakeup
+            while (sleeping != waiters) {
+                uniq_lck.unlock();
+                std::this_thread::yield();
+                uniq_lck.lock();
+            }
+        }
+
+        ++posted;
+        ++notify_count;
+        notify_time = bench_clock::now();
+        uniq_lck.unlock();
+
+        if (notify == Notify::one) {
+            cond_var.notify_one();
+        }
+        else {
+            cond_var.notify_all();
+        }
+
+        // Give the waiters a while to pick the item up
+        auto deadline = bench_clock::now() + 20ms;
+        uniq_lck.lock();
+        while (consumed < posted && bench_clock::now() < deadline) {
+            uniq_lck.unlock();
+            std::this_thread::yield();
+            uniq_lck.lock();
+        }
+
+        if (consumed < posted) {
+            ++report.lost;
+            // Nobody will ever wake up for it, drop it and move on
+            consumed = posted;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        done = true;
+    }
+    cond_var.notify_all();
+    for (auto &thr : threads) {
+        thr.join();
+    }
+    return report;
+}
+
+int main(int argc, char *argv[]) {
+    int rounds = 200;
+    bool verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "-v") {
+            verbose = true;
+        }
+        else {
+            rounds = std::stoi(arg);
+        }
+    }
+
+    std::cout << std::left << std::setw(9) << "protocol" << std::setw(12) << "notify"
+              << std::right << std::setw(8) << "waiters" << std::setw(12) << "p50 ns" << std::setw(12) << "p99 ns"
+              << std::setw(12) << "p99.9 ns" << std::setw(12) << "max ns" << std::setw(9) << "useful"
+              << std::setw(9) << "futile" << std::setw(10) << "spurious" << std::setw(7) << "lost" << std::endl;
+
+    for (Protocol protocol : {Protocol::correct, Protocol::naive}) {
+        for (Notify notify : {Notify::one, Notify::all}) {
+            for (int waiters = 1; waiters <= 64; waiters *= 2) {
+                WakeupReport r = run_wakeup_test(waiters, rounds, notify, protocol);
+
+                std::cout << std::left << std::setw(9) << (protocol == Protocol::correct ? "correct" : "naive")
+                          << std::setw(12) << (notify == Notify::one ? "notify_one" : "notify_all")
+                          << std::right << std::setw(8) << waiters
+                          << std::setw(12) << r.latency.percentile(0.50)
+                          << std::setw(12) << r.latency.percentile(0.99)
+                          << std::setw(12) << r.latency.percentile(0.999)
+                          << std::setw(12) << r.latency.max()
+                          << std::setw(9) << r.useful << std::setw(9) << r.futile
+                          << std::setw(10) << r.spurious << std::setw(7) << r.lost << std::endl;
+                if (verbose) {
+                    r.latency.print(std::cout);
+                }
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#include "elastic_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "run_task.h"
+
+ElasticPool::ElasticPool(ElasticPoolOptions pool_options) : options(pool_options)
+{
+    if (options.max_threads == 0 || options.min_threads > options.max_threads) {
+        throw std::invalid_argument("ElasticPool: need 0 < max_threads and min_threads <= max_threads");
+    }
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        last_grow = clock::now();
+        for (unsigned i = 0; i < options.min_threads; ++i) {
+            add_worker();
+        }
+    }
+    monitor = std::thread(&ElasticPool::monitor_loop, this);
+}
+
+ElasticPool::~ElasticPool()
+{
+    std::vector<std::thread> to_join;
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        stopping = true;
+        // With min_threads == 0 there may be queued tasks and nobody left to run them
+        if (threads.empty() && !tasks.empty()) {
+            add_worker();
+        }
+        for (auto &entry : threads) {
+            to_join.push_back(std::move(entry.second));
+        }
+        threads.clear();
+        for (auto &thr : exited) {
+            to_join.push_back(std::move(thr));
+        }
+        exited.clear();
+    }
+    work_cv.notify_all();
+    monitor_cv.notify_all();
+    monitor.join();
+    for (auto &thr : to_join) {
+        thr.join();
+    }
+}
+
+// Called with mut held
+void ElasticPool::add_worker()
+{
+    // Retired workers have let go of the lock for the last time, so they can be joined here
+    for (auto &thr : exited) {
+        thr.join();
+    }
+    exited.clear();
+
+    std::uint64_t id = next_worker_id++;
+    threads.emplace(id, std::thread(&ElasticPool::worker_loop, this, id));
+    ++counters.threads;
+    ++counters.started;
+    counters.peak_threads = std::max(counters.peak_threads, counters.threads);
+}
+
+// Called with mut held
+void ElasticPool::maybe_grow(clock::time_point now)
+{
+    if (stopping || tasks.empty() || counters.idle > 0 || counters.threads >= options.max_threads) {
+        return;
+    }
+    if (now - tasks.front().queued_at < options.target_wait || now - last_grow < options.grow_interval) {
+        return;
+    }
+    last_grow = now;
+    add_worker();
+}
+
+void ElasticPool::submit(Task task)
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    auto now = clock::now();
+    tasks.push_back(Item{std::move(task), now});
+    maybe_grow(now);
+    bool wake = counters.idle > 0;
+    bool was_empty = tasks.size() == 1;
+    uniq_lck.unlock();
+    if (wake) {
+        work_cv.notify_one();
+    }
+    if (was_empty) {
+        monitor_cv.notify_one();
+    }
+}
+
+void ElasticPool::worker_loop(std::uint64_t id)
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    while (true) {
+        if (tasks.empty()) {
+            if (stopping) {
+                break;
+            }
+            ++counters.idle;
+            bool woken = work_cv.wait_for(uniq_lck, options.idle_timeout, [this] {
+                return !tasks.empty() || stopping;
+            });
+            --counters.idle;
+            if (!woken && counters.threads > options.min_threads) {
+                // Idle for too long: retire, the next add_worker() or the destructor joins us
+                --counters.threads;
+                ++counters.retired;
+                exited.push_back(std::move(threads[id]));
+                threads.erase(id);
+                break;
+            }
+            continue;
+        }
+
+        auto now = clock::now();
+        Item item = std::move(tasks.front());
+        tasks.pop_front();
+        average_wait_ns += (std::chrono::duration<double, std::nano>(now - item.queued_at).count() - average_wait_ns) / 16;
+        maybe_grow(now);
+
+        uniq_lck.unlock();
+        run_task(item.task, "ElasticPool");
+        item.task = nullptr;
+        uniq_lck.lock();
+        ++counters.completed;
+    }
+}
+
+void ElasticPool::monitor_loop()
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    while (!stopping) {
+        if (tasks.empty()) {
+            monitor_cv.wait(uniq_lck, [this] {return !tasks.empty() || stopping;});
+            continue;
+        }
+        monitor_cv.wait_for(uniq_lck, options.grow_interval, [this] {return stopping;});
+        maybe_grow(clock::now());
+    }
+}
+
+ElasticPoolStats ElasticPool::stats()
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    ElasticPoolStats result = counters;
+    result.queued = tasks.size();
+    if (!tasks.empty()) {
+        result.oldest_wait = std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - tasks.front().queued_at);
+    }
+    result.average_wait = std::chrono::nanoseconds(static_cast<std::int64_t>(average_wait_ns));
+    return result;
+}
@@ -0,0 +1,117 @@
+#ifndef ELASTIC_POOL_ELASTIC_POOL_H
+#define ELASTIC_POOL_ELASTIC_POOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * Elastic Worker Pool
+ *
+ * - A fixed pool has to be sized for something
+ *      - For the average load: bursts queue up behind too few workers
+ *      - For the peak: most of the threads sit idle most of the time, each with its own stack
+ * - An elastic pool sizes itself from how long tasks wait
+ *
+ * - Growing
+ *      - When the oldest waiting task has waited longer than target_wait and no worker is idle,
+ *              one worker is added
+ *      - Checked on submit(), whenever a worker takes a task, and every grow_interval by a monitor thread
+ *              - The monitor is for the case where every worker is stuck in a long task:
+ *                      then nobody takes a task, and the queue could wait forever
+ *              - It only runs while something is queued
+ *      - At most one new worker per grow_interval, so a burst does not start max_threads at once
+ *              before the first new ones had a chance to help
+ *
+ * - Shrinking
+ *      - A worker which finds nothing to do for idle_timeout retires, down to min_threads
+ *      - min_threads may be 0, then the destructor starts one worker if tasks are still queued:
+ *              every submitted task runs before the destructor returns
+ *
+ * - Hysteresis: grow after a millisecond of waiting, shrink after half a second of idleness
+ *      - The two thresholds are far apart, so the pool does not start and stop threads
+ *              on every small change in load
+ *
+ * - stats() exports the thread count, the queue length, and the time tasks wait
+ *      - oldest_wait is how long the task at the front has waited so far
+ *      - average_wait is a moving average of the wait of the tasks taken recently
+ *
+ * - Meant for tasks which block (I/O, sleeps like fetch_data's): there, more threads means more
+ *      done at once. For CPU-bound tasks more threads than cores only adds switching
+ *
+ * - A task which throws is reported and skipped, see run_task.h in worker_pool
+ *      */
+
+struct ElasticPoolOptions {
+    unsigned min_threads = 1;
+    unsigned max_threads = 64;
+    std::chrono::microseconds target_wait {std::chrono::milliseconds(1)};
+    std::chrono::microseconds grow_interval {std::chrono::milliseconds(1)};
+    std::chrono::milliseconds idle_timeout {500};
+};
+
+struct ElasticPoolStats {
+    unsigned threads {0};
+    unsigned idle {0};
+    unsigned peak_threads {0};
+    std::size_t queued {0};
+    std::chrono::nanoseconds oldest_wait {0};
+    std::chrono::nanoseconds average_wait {0};
+    std::uint64_t started {0};      // workers started, the first min_threads included
+    std::uint64_t retired {0};
+    std::uint64_t completed {0};    // tasks
+};
+
+class ElasticPool {
+public:
+    using Task = std::function<void()>;
+    using clock = std::chrono::steady_clock;
+
+private:
+    struct Item {
+        Task task;
+        clock::time_point queued_at;
+    };
+
+    ElasticPoolOptions options;
+
+    std::mutex mut;
+    std::condition_variable work_cv;
+    std::condition_variable monitor_cv;
+    std::deque<Item> tasks;
+    bool stopping = false;
+
+    std::unordered_map<std::uint64_t, std::thread> threads;
+    std::vector<std::thread> exited;    // retired workers, joined later
+    std::uint64_t next_worker_id = 0;
+    clock::time_point last_grow;
+    double average_wait_ns = 0;
+    ElasticPoolStats counters;
+
+    std::thread monitor;
+
+    void add_worker();
+    void maybe_grow(clock::time_point now);
+    void worker_loop(std::uint64_t id);
+    void monitor_loop();
+
+public:
+    explicit ElasticPool(ElasticPoolOptions pool_options = ElasticPoolOptions());
+    ~ElasticPool();
+
+    ElasticPool(const ElasticPool &source) = delete;
+    ElasticPool &operator=(const ElasticPool &source) = delete;
+
+    void submit(Task task);
+
+    ElasticPoolStats stats();
+};
+
+#endif //ELASTIC_POOL_ELASTIC_POOL_H
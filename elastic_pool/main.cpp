@@ -0,0 +1,131 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <vector>
+
+#include "elastic_pool.h"
+#include "latency_histogram.h"
+
+using namespace std::literals;
+
+/*
+ * Twenty fetch_data() downloads of 100ms at once, on a pool that starts with 1 thread
+ * - The pool grows while the downloads wait, then shrinks back after 200ms of idleness
+ *      */
+
+void download_example()
+{
+    ElasticPoolOptions options;
+    options.max_threads = 8;
+    options.idle_timeout = 200ms;
+    ElasticPool pool(options);
+
+    for (int i = 0; i < 20; ++i) {
+        pool.submit([] {std::this_thread::sleep_for(100ms);});
+    }
+    for (int ms = 0; ms <= 600; ms += 100) {
+        ElasticPoolStats s = pool.stats();
+        std::cout << ms << "ms: " << s.threads << " threads, " << s.queued << " queued, " << s.completed
+                  << " done, oldest waiting " << std::chrono::duration_cast<std::chrono::milliseconds>(s.oldest_wait).count()
+                  << "ms" << std::endl;
+        std::this_thread::sleep_for(100ms);
+    }
+}
+
+/*
+ * Bursty load
+ * - 5 bursts of 200 tasks, 300ms apart, each task blocks for 1ms (like a small download)
+ * - fixed 2:  sized for the average, bursts queue up
+ * - fixed 32: sized for the peak, threads idle between bursts
+ * - elastic 2..64, idle_timeout 100ms
+ * - Reports how long the tasks waited, and what the threads cost:
+ *      - peak, and thread-seconds (threads alive, sampled every ms, times the time)
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+struct BurstResult {
+    LatencyHistogram wait;
+    unsigned peak_threads;
+    unsigned end_threads;
+    double thread_seconds;
+};
+
+BurstResult bursty_load(ElasticPoolOptions options, int bursts, int burst_size)
+{
+    LatencyRecorder wait;
+    BurstResult result {};
+    {
+        ElasticPool pool(options);
+        // Each sample counts for the time since the previous one: sleep_for(1ms) often sleeps longer
+        double thread_seconds {0};
+        auto last_sample = bench_clock::now();
+        for (int b = 0; b < bursts; ++b) {
+            for (int i = 0; i < burst_size; ++i) {
+                auto queued_at = bench_clock::now();
+                pool.submit([&wait, queued_at] {
+                    wait.record(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - queued_at).count());
+                    std::this_thread::sleep_for(1ms);
+                });
+            }
+            auto next_burst = bench_clock::now() + 300ms;
+            while (last_sample < next_burst) {
+                std::this_thread::sleep_for(1ms);
+                auto now = bench_clock::now();
+                thread_seconds += pool.stats().threads * std::chrono::duration<double>(now - last_sample).count();
+                last_sample = now;
+            }
+        }
+        ElasticPoolStats s = pool.stats();
+        result.peak_threads = s.peak_threads;
+        result.end_threads = s.threads;
+        result.thread_seconds = thread_seconds;
+    }
+    result.wait = wait.snapshot();
+    return result;
+}
+
+int main() {
+    std::thread thread4(download_example);
+    thread4.join();
+
+    ElasticPoolOptions fixed_small;
+    fixed_small.min_threads = fixed_small.max_threads = 2;
+    ElasticPoolOptions fixed_large;
+    fixed_large.min_threads = fixed_large.max_threads = 32;
+    ElasticPoolOptions elastic;
+    elastic.min_threads = 2;
+    elastic.max_threads = 64;
+    elastic.idle_timeout = 100ms;
+
+    struct Config {
+        std::string label;
+        ElasticPoolOptions options;
+    };
+    std::vector<Config> configs {{"fixed 2", fixed_small}, {"fixed 32", fixed_large}, {"elastic 2..64", elastic}};
+
+    std::vector<BurstResult> results;
+    for (auto &config : configs) {
+        results.push_back(bursty_load(config.options, 5, 200));
+    }
+
+    std::cout << "\n5 bursts of 200 x 1ms tasks, 300ms apart: queue wait" << std::endl;
+    LatencyHistogram::print_summary_header(std::cout);
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        results[i].wait.print_summary(std::cout, configs[i].label);
+    }
+
+    std::cout << "\n" << std::left << std::setw(16) << "pool" << std::right << std::setw(8) << "peak"
+              << std::setw(8) << "end" << std::setw(18) << "thread-seconds" << std::endl;
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        std::cout << std::left << std::setw(16) << configs[i].label << std::right << std::setw(8)
+                  << results[i].peak_threads << std::setw(8) << results[i].end_threads << std::fixed
+                  << std::setprecision(2) << std::setw(18) << results[i].thread_seconds << std::defaultfloat
+                  << std::endl;
+    }
+
+    return 0;
+}
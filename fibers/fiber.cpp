@@ -0,0 +1,359 @@
+#include "fiber.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <system_error>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#if defined(__x86_64__)
+
+/*
+ * fiber_switch_context(void **save_sp, void *load_sp)
+ * - Saves the callee-saved registers on the current stack, stores rsp in *save_sp,
+ *      switches to load_sp and restores the registers saved there
+ * - Everything else (rax, rcx, the xmm registers...) the caller has saved already if it needs it,
+ *      the System V ABI says a called function may overwrite them
+ * - The SSE (mxcsr) and x87 control words are callee-saved too: rounding mode and exception masks
+ *
+ * fiber_trampoline
+ * - Where a new fiber "returns" to on its first switch, the Fiber is in r12
+ *      */
+asm(R"(
+    .text
+    .globl fiber_switch_context
+    .type fiber_switch_context, @function
+    .align 16
+fiber_switch_context:
+    pushq %rbp
+    pushq %rbx
+    pushq %r12
+    pushq %r13
+    pushq %r14
+    pushq %r15
+    subq $8, %rsp
+    stmxcsr (%rsp)
+    fnstcw 4(%rsp)
+    movq %rsp, (%rdi)
+    movq %rsi, %rsp
+    ldmxcsr (%rsp)
+    fldcw 4(%rsp)
+    addq $8, %rsp
+    popq %r15
+    popq %r14
+    popq %r13
+    popq %r12
+    popq %rbx
+    popq %rbp
+    ret
+    .size fiber_switch_context, .-fiber_switch_context
+
+    .globl fiber_trampoline
+    .type fiber_trampoline, @function
+    .align 16
+fiber_trampoline:
+    movq %r12, %rdi
+    call fiber_entry@PLT
+    ud2
+    .size fiber_trampoline, .-fiber_trampoline
+)");
+
+extern "C" void fiber_switch_context(void **save_sp, void *load_sp);
+extern "C" void fiber_trampoline();
+
+static void switch_context(FiberContext &from, FiberContext &to)
+{
+    fiber_switch_context(&from.sp, to.sp);
+}
+
+#else
+
+static void switch_context(FiberContext &from, FiberContext &to)
+{
+    swapcontext(&from.uc, &to.uc);
+}
+
+#endif
+
+extern "C" void fiber_entry(Fiber *fiber) noexcept
+{
+    fiber_run(fiber);
+}
+
+#if !defined(__x86_64__)
+// makecontext() only passes ints
+static void fiber_uc_entry(unsigned high, unsigned low)
+{
+    fiber_entry(reinterpret_cast<Fiber *>((static_cast<std::uintptr_t>(high) << 32) | low));
+}
+#endif
+
+/*
+ * The OS thread's own context, and the fiber it is running
+ * - Only reached through this function, which the compiler cannot see into:
+ *      a fiber that moved to another thread must not use the address it had before the switch
+ *      */
+struct WorkerState {
+    FiberContext context;
+    Fiber *running = nullptr;
+};
+
+__attribute__((noinline)) static WorkerState &this_worker()
+{
+    static thread_local WorkerState state;
+    asm volatile("" ::: "memory");
+    return state;
+}
+
+Fiber::Fiber(FiberScheduler *owner, std::function<void()> body, const FiberOptions &options)
+        : fn(std::move(body)), scheduler(owner)
+{
+    std::size_t page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    std::size_t stack_size = (options.stack_size + page - 1) / page * page;
+    std::size_t guard_size = options.guard_page ? page : 0;
+    mapping_size = stack_size + guard_size;
+
+    void *p = mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+    if (p == MAP_FAILED) {
+        throw std::system_error(errno, std::generic_category(), "Fiber: mmap of the stack failed");
+    }
+    mapping = static_cast<char *>(p);
+    if (guard_size && mprotect(mapping, guard_size, PROT_NONE) != 0) {
+        int error = errno;
+        munmap(mapping, mapping_size);
+        throw std::system_error(error, std::generic_category(), "Fiber: mprotect of the guard page failed");
+    }
+
+#if defined(__x86_64__)
+    /*
+     * The first switch into the fiber pops this frame (see fiber_switch_context), from the top:
+     *      - 16 bytes of padding, so rsp is 16-byte aligned when fiber_trampoline makes its call
+     *      - return address: fiber_trampoline
+     *      - rbp, rbx, r12 (the Fiber), r13, r14, r15
+     *      - mxcsr and the x87 control word, at their default values
+     *      */
+    std::uintptr_t top = reinterpret_cast<std::uintptr_t>(mapping + mapping_size) & ~std::uintptr_t{15};
+    auto *frame = reinterpret_cast<std::uint64_t *>(top - 80);
+    std::memset(frame, 0, 80);
+    std::uint32_t mxcsr = 0x1f80;
+    std::uint16_t fpu_control = 0x037f;
+    std::memcpy(reinterpret_cast<char *>(frame), &mxcsr, sizeof(mxcsr));
+    std::memcpy(reinterpret_cast<char *>(frame) + 4, &fpu_control, sizeof(fpu_control));
+    frame[4] = reinterpret_cast<std::uint64_t>(this);
+    frame[7] = reinterpret_cast<std::uint64_t>(&fiber_trampoline);
+    context.sp = frame;
+#else
+    getcontext(&context.uc);
+    context.uc.uc_stack.ss_sp = mapping + guard_size;
+    context.uc.uc_stack.ss_size = stack_size;
+    context.uc.uc_link = nullptr;
+    std::uintptr_t self = reinterpret_cast<std::uintptr_t>(this);
+    makecontext(&context.uc, reinterpret_cast<void (*)()>(fiber_uc_entry), 2,
+                static_cast<unsigned>(self >> 32), static_cast<unsigned>(self & 0xffffffffu));
+#endif
+}
+
+Fiber::~Fiber()
+{
+    munmap(mapping, mapping_size);
+}
+
+void fiber_run(Fiber *fiber)
+{
+    try {
+        fiber->fn();
+    }
+    catch (...) {
+        // Letting it out of the fiber would reach fiber_entry (noexcept) and terminate
+        FiberScheduler *scheduler = fiber->scheduler;
+        std::lock_guard<std::mutex> lck_guard(scheduler->mut);
+        if (!scheduler->error) {
+            scheduler->error = std::current_exception();
+        }
+    }
+    // Whatever the function captured is destroyed here, still on the fiber's own stack
+    fiber->fn = nullptr;
+    FiberScheduler::switch_out(fiber, Fiber::After::finish, nullptr);
+}
+
+FiberScheduler::FiberScheduler(unsigned thread_count, FiberOptions fiber_options) : options(fiber_options)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&FiberScheduler::worker_loop, this);
+    }
+}
+
+FiberScheduler::~FiberScheduler()
+{
+    // Not join(): a destructor must not rethrow a fiber's exception
+    wait_for_fibers();
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (auto &thr : threads) {
+        thr.join();
+    }
+}
+
+void FiberScheduler::spawn(std::function<void()> fn)
+{
+    Fiber *fiber = new Fiber(this, std::move(fn), options);
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        ++live;
+        ready.push_back(fiber);
+    }
+    work_cv.notify_one();
+}
+
+void FiberScheduler::wait_for_fibers()
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    done_cv.wait(uniq_lck, [this] {return live == 0;});
+}
+
+void FiberScheduler::join()
+{
+    wait_for_fibers();
+    std::exception_ptr fiber_error;
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        fiber_error.swap(error);
+    }
+    if (fiber_error) {
+        std::rethrow_exception(fiber_error);
+    }
+}
+
+void FiberScheduler::make_ready(Fiber *fiber)
+{
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        ready.push_back(fiber);
+    }
+    work_cv.notify_one();
+}
+
+Fiber *FiberScheduler::next_fiber()
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    while (true) {
+        auto now = std::chrono::steady_clock::now();
+        while (!sleepers.empty() && sleepers.top().wake_at <= now) {
+            ready.push_back(sleepers.top().fiber);
+            sleepers.pop();
+        }
+        if (!ready.empty()) {
+            Fiber *fiber = ready.front();
+            ready.pop_front();
+            if (!ready.empty() && threads.size() > 1) {
+                work_cv.notify_one();
+            }
+            return fiber;
+        }
+        if (stopping) {
+            return nullptr;
+        }
+        if (sleepers.empty()) {
+            work_cv.wait(uniq_lck);
+        }
+        else {
+            work_cv.wait_until(uniq_lck, sleepers.top().wake_at);
+        }
+    }
+}
+
+void FiberScheduler::after_switch(Fiber *fiber)
+{
+    switch (fiber->after) {
+        case Fiber::After::requeue:
+            make_ready(fiber);
+            break;
+        case Fiber::After::park:
+            fiber->unlock_after->unlock();
+            break;
+        case Fiber::After::finish: {
+            delete fiber;
+            std::lock_guard<std::mutex> lck_guard(mut);
+            if (--live == 0) {
+                done_cv.notify_all();
+            }
+            break;
+        }
+    }
+}
+
+void FiberScheduler::worker_loop()
+{
+    while (Fiber *fiber = next_fiber()) {
+        WorkerState &worker = this_worker();
+        worker.running = fiber;
+        switch_context(worker.context, fiber->context);
+        // Back on this thread's own stack, which never moves
+        worker.running = nullptr;
+        after_switch(fiber);
+    }
+}
+
+void FiberScheduler::switch_out(Fiber *fiber, Fiber::After what, std::mutex *guard)
+{
+    fiber->after = what;
+    fiber->unlock_after = guard;
+    switch_context(fiber->context, this_worker().context);
+}
+
+Fiber *FiberScheduler::current()
+{
+    return this_worker().running;
+}
+
+void FiberScheduler::park(std::mutex &guard)
+{
+    switch_out(current(), Fiber::After::park, &guard);
+}
+
+void FiberScheduler::wake(Fiber *fiber)
+{
+    fiber->scheduler->make_ready(fiber);
+}
+
+void FiberScheduler::yield()
+{
+    Fiber *fiber = current();
+    if (!fiber) {
+        std::this_thread::yield();
+        return;
+    }
+    switch_out(fiber, Fiber::After::requeue, nullptr);
+}
+
+void FiberScheduler::sleep_until(std::chrono::steady_clock::time_point wake_at)
+{
+    Fiber *fiber = current();
+    if (!fiber) {
+        std::this_thread::sleep_until(wake_at);
+        return;
+    }
+    FiberScheduler &scheduler = *fiber->scheduler;
+    scheduler.mut.lock();
+    scheduler.sleepers.push(Sleeper{wake_at, fiber});
+    switch_out(fiber, Fiber::After::park, &scheduler.mut);
+}
+
+void fiber_yield()
+{
+    FiberScheduler::yield();
+}
+
+void fiber_sleep_for(std::chrono::steady_clock::duration duration)
+{
+    FiberScheduler::sleep_until(std::chrono::steady_clock::now() + duration);
+}
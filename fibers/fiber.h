@@ -0,0 +1,167 @@
+#ifndef FIBERS_FIBER_H
+#define FIBERS_FIBER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#if !defined(__x86_64__)
+#include <ucontext.h>
+#endif
+
+/*
+ * Fibers
+ *
+ * - fetch_data(), progress_bar() and process_data() each get a kernel thread
+ *      - A thread costs a kernel task, a stack of megabytes (virtual), and a trip through the
+ *              kernel scheduler for every block and wakeup
+ *      - Thousands of them are fine, hundreds of thousands are not
+ * - A fiber is a thread the program schedules itself
+ *      - Its own stack, so code can still be written as "sleep, then lock, then wait"
+ *      - Switching is saving the callee-saved registers and the stack pointer of one fiber
+ *              and loading those of the other: no system call, no kernel scheduler
+ *      - M fibers run on N OS threads (M:N), any fiber on any of them
+ *
+ * - Context switch (x86-64)
+ *      - fiber_switch_context(&from_sp, to_sp), hand-written in fiber.cpp
+ *      - Pushes rbp, rbx, r12-r15 and the SSE/x87 control words, saves rsp, loads the other rsp,
+ *              pops the same and returns, into the other fiber
+ *      - A new fiber's stack is set up to look as if it had been switched out at its first instruction
+ *      - Other architectures fall back to swapcontext(), which works the same way but also
+ *              saves the signal mask, with a system call
+ *
+ * - Blocking without blocking the OS thread
+ *      - fiber_sleep_for(), FiberMutex and FiberConditionVariable (fiber_sync.h) park the fiber:
+ *              it is put on a waiting list and the OS thread switches to another ready fiber
+ *      - std::mutex, std::condition_variable and std::this_thread::sleep_for inside a fiber
+ *              still block the whole OS thread, with every fiber that could have run on it
+ *
+ * - Stacks are fixed size, 64KB by default, mmap()ed so only the pages touched use memory
+ *      - A guard page below each stack turns an overflow into a crash instead of silent corruption
+ *      - But each guarded stack is 2 memory mappings, and Linux allows 65530 by default:
+ *              for hundreds of thousands of fibers turn guard_page off
+ *
+ * - An exception escaping a fiber's function is caught, the fiber ends there
+ *      - join() rethrows the first one, the destructor (which has to wait without throwing) drops it
+ *
+ * - Do not keep the address of a thread_local across a switch: the fiber may wake up on another
+ *      OS thread
+ *      */
+
+struct FiberOptions {
+    std::size_t stack_size = 64 * 1024;
+    bool guard_page = true;
+};
+
+class FiberScheduler;
+
+struct FiberContext {
+#if defined(__x86_64__)
+    void *sp = nullptr;
+#else
+    ucontext_t uc;
+#endif
+};
+
+class Fiber {
+public:
+    // What the OS thread does once it has switched away from the fiber
+    enum class After {requeue, park, finish};
+
+private:
+    std::function<void()> fn;
+    FiberContext context;
+    FiberScheduler *scheduler;
+    char *mapping = nullptr;
+    std::size_t mapping_size = 0;
+
+    After after = After::requeue;
+    std::mutex *unlock_after = nullptr;
+
+    friend class FiberScheduler;
+    friend void fiber_run(Fiber *fiber);
+
+public:
+    Fiber(FiberScheduler *owner, std::function<void()> body, const FiberOptions &options);
+    ~Fiber();
+
+    Fiber(const Fiber &source) = delete;
+    Fiber &operator=(const Fiber &source) = delete;
+};
+
+class FiberScheduler {
+private:
+    struct Sleeper {
+        std::chrono::steady_clock::time_point wake_at;
+        Fiber *fiber;
+
+        bool operator>(const Sleeper &other) const { return wake_at > other.wake_at; }
+    };
+
+    FiberOptions options;
+
+    std::mutex mut;
+    std::condition_variable work_cv;
+    std::condition_variable done_cv;
+    std::deque<Fiber *> ready;
+    std::priority_queue<Sleeper, std::vector<Sleeper>, std::greater<Sleeper>> sleepers;
+    std::size_t live = 0;
+    bool stopping = false;
+    std::exception_ptr error;   // the first exception a fiber threw, until join() rethrows it
+
+    std::vector<std::thread> threads;
+
+    void wait_for_fibers();
+    Fiber *next_fiber();
+    void worker_loop();
+    void after_switch(Fiber *fiber);
+    void make_ready(Fiber *fiber);
+    static void switch_out(Fiber *fiber, Fiber::After what, std::mutex *guard);
+
+    friend void fiber_run(Fiber *fiber);
+
+public:
+    // thread_count OS threads run the fibers, 0 means one per hardware thread
+    explicit FiberScheduler(unsigned thread_count = 1, FiberOptions fiber_options = FiberOptions());
+    // Waits for every fiber to finish
+    ~FiberScheduler();
+
+    FiberScheduler(const FiberScheduler &source) = delete;
+    FiberScheduler &operator=(const FiberScheduler &source) = delete;
+
+    // From any thread or fiber
+    // If fn throws, the fiber finishes there and join() rethrows the exception
+    void spawn(std::function<void()> fn);
+
+    // Returns once every fiber spawned so far, and every fiber they spawned, has finished
+    // Then rethrows the first exception any of them threw, if one did
+    void join();
+
+    // The fiber running on the calling thread, nullptr outside a fiber
+    static Fiber *current();
+
+    // From inside a fiber: switch away until someone calls wake() with it
+    // guard must be locked, it is unlocked once the fiber has been switched out,
+    // so whoever wakes the fiber (under guard) cannot resume it before it is
+    static void park(std::mutex &guard);
+    // From anywhere: makes a parked fiber ready to run again
+    static void wake(Fiber *fiber);
+
+    static void yield();
+    static void sleep_until(std::chrono::steady_clock::time_point wake_at);
+};
+
+// Lets the other ready fibers run
+void fiber_yield();
+
+// Parks the fiber, not the OS thread
+void fiber_sleep_for(std::chrono::steady_clock::duration duration);
+
+#endif //FIBERS_FIBER_H
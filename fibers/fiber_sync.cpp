@@ -0,0 +1,79 @@
+#include "fiber_sync.h"
+
+void FiberMutex::lock()
+{
+    guard.lock();
+    if (!locked) {
+        locked = true;
+        guard.unlock();
+        return;
+    }
+    waiters.push_back(FiberScheduler::current());
+    // unlock() makes us the owner before it wakes us
+    FiberScheduler::park(guard);
+}
+
+bool FiberMutex::try_lock()
+{
+    std::lock_guard<std::mutex> lck_guard(guard);
+    if (locked) {
+        return false;
+    }
+    locked = true;
+    return true;
+}
+
+void FiberMutex::unlock()
+{
+    Fiber *next = nullptr;
+    {
+        std::lock_guard<std::mutex> lck_guard(guard);
+        if (waiters.empty()) {
+            locked = false;
+        }
+        else {
+            // Stays locked, now on behalf of next
+            next = waiters.front();
+            waiters.pop_front();
+        }
+    }
+    if (next) {
+        FiberScheduler::wake(next);
+    }
+}
+
+void FiberConditionVariable::wait(std::unique_lock<FiberMutex> &lock)
+{
+    guard.lock();
+    waiters.push_back(FiberScheduler::current());
+    lock.unlock();
+    FiberScheduler::park(guard);
+    lock.lock();
+}
+
+void FiberConditionVariable::notify_one()
+{
+    Fiber *next = nullptr;
+    {
+        std::lock_guard<std::mutex> lck_guard(guard);
+        if (!waiters.empty()) {
+            next = waiters.front();
+            waiters.pop_front();
+        }
+    }
+    if (next) {
+        FiberScheduler::wake(next);
+    }
+}
+
+void FiberConditionVariable::notify_all()
+{
+    std::deque<Fiber *> woken;
+    {
+        std::lock_guard<std::mutex> lck_guard(guard);
+        woken.swap(waiters);
+    }
+    for (Fiber *fiber : woken) {
+        FiberScheduler::wake(fiber);
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef FIBERS_FIBER_SYNC_H
+#define FIBERS_FIBER_SYNC_H
+
+#include <deque>
+#include <mutex>
+
+#include "fiber.h"
+
+/*
+ * FiberMutex and FiberConditionVariable
+ *
+ * - Same interface as std::mutex and std::condition_variable, so std::lock_guard,
+ *      std::unique_lock and wait(lock, predicate) all work with them
+ * - A fiber which has to wait is parked, and its OS thread runs other fibers meanwhile
+ * - Each has a small std::mutex inside, only ever held for a few instructions,
+ *      to protect its list of waiting fibers
+ *
+ * - FiberMutex hands the lock over directly on unlock()
+ *      - The first waiter becomes the owner before it even runs, so nobody can barge in
+ *              between (fair, FIFO)
+ * - FiberConditionVariable::wait() queues the fiber and unlocks the FiberMutex before parking,
+ *      under its own guard, so a notify cannot slip in between the two
+ *
+ * - Only for use from inside fibers
+ *      */
+
+class FiberMutex {
+private:
+    std::mutex guard;
+    bool locked = false;
+    std::deque<Fiber *> waiters;
+
+public:
+    void lock();
+    bool try_lock();
+    void unlock();
+};
+
+class FiberConditionVariable {
+private:
+    std::mutex guard;
+    std::deque<Fiber *> waiters;
+
+public:
+    void wait(std::unique_lock<FiberMutex> &lock);
+
+    template <typename Predicate>
+    void wait(std::unique_lock<FiberMutex> &lock, Predicate pred)
+    {
+        while (!pred()) {
+            wait(lock);
+        }
+    }
+
+    void notify_one();
+    void notify_all();
+};
+
+#endif //FIBERS_FIBER_SYNC_H
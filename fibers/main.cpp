@@ -0,0 +1,240 @@
+#include <iostream>
+#include <atomic>
+#include <iomanip>
+#include <fstream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+
+#include "fiber.h"
+#include "fiber_sync.h"
+
+using namespace std::literals;
+
+/*
+ * fetch_data(), progress_bar() and process_data() from thread_synchronization, as fibers
+ * - All three run on one OS thread
+ * - The same code as with threads, with the fiber versions of sleep_for, mutex and condition variable
+ * - The sleeps are 200ms instead of 2s
+ *      */
+
+std::string downloaded_data;
+FiberMutex data_lock;
+FiberConditionVariable download_condition_variable;
+bool string_updated = false;
+bool download_complete = false;
+
+void fetch_data()
+{
+    for (int i = 0; i < 5; ++i) {
+        fiber_sleep_for(200ms);
+        std::lock_guard<FiberMutex> lock_guard(data_lock);
+        downloaded_data += "Block" + std::to_string(i + 1);
+        string_updated = true;
+        download_condition_variable.notify_all();
+    }
+    std::lock_guard<FiberMutex> final_lock_guard(data_lock);
+    download_complete = true;
+    download_condition_variable.notify_all();
+}
+
+void progress_bar()
+{
+    std::unique_lock<FiberMutex> uniq_lck(data_lock);
+    while (!download_complete) {
+        download_condition_variable.wait(uniq_lck, [] {return string_updated || download_complete;});
+        string_updated = false;
+        std::cout << "Received " << downloaded_data.size() << " bytes so far....." << std::endl;
+    }
+}
+
+void process_data()
+{
+    std::unique_lock<FiberMutex> uniq_lck(data_lock);
+    download_condition_variable.wait(uniq_lck, [] {return download_complete;});
+    std::cout << "Processing data: " << downloaded_data << std::endl;
+}
+
+/*
+ * Benchmarks
+ * - switch: two fibers on one OS thread yield to each other, against two OS threads handing
+ *      a turn back and forth with a mutex and a condition variable
+ *      - A fiber yield is two switches, into the scheduler loop and out to the other fiber
+ * - downloads: n flows of 5 blocks, each block a 20-29ms wait, then a shared counter update
+ *      - 100000 fibers on one OS thread, with 16KB stacks and no guard pages
+ *      - Against 2000 OS threads doing the same with std:: primitives
+ *      - Peak memory is VmHWM after resetting it (/proc/self/clear_refs)
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+double elapsed_ms(bench_clock::time_point start)
+{
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+void reset_peak_memory()
+{
+    std::ofstream("/proc/self/clear_refs") << "5";
+}
+
+double peak_memory_mb()
+{
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmHWM:", 0) == 0) {
+            return std::stod(line.substr(6)) / 1024;
+        }
+    }
+    return 0;
+}
+
+// Both sides meet first and the clock starts when the second one arrives, so starting and
+// stopping threads or the scheduler is not part of the time
+void switch_benchmark(int rounds)
+{
+    std::cout << std::left << std::setw(24) << "switch" << std::right << std::setw(14) << "ns per yield" << std::endl;
+
+    std::atomic<int> arrived {0};
+    std::atomic<int> running {2};
+    bench_clock::time_point start;
+    bench_clock::time_point stop;
+    {
+        FiberScheduler scheduler(1);
+        for (int f = 0; f < 2; ++f) {
+            scheduler.spawn([&, rounds] {
+                if (arrived.fetch_add(1) == 1) {
+                    start = bench_clock::now();
+                }
+                while (arrived.load() < 2) {
+                    fiber_yield();
+                }
+                for (int i = 0; i < rounds; ++i) {
+                    fiber_yield();
+                }
+                if (running.fetch_sub(1) == 1) {
+                    stop = bench_clock::now();
+                }
+            });
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count() / (2.0 * rounds);
+    std::cout << std::left << std::setw(24) << "fiber yield" << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << ns << std::defaultfloat << std::endl;
+
+    // The same ping-pong with two threads and a condition variable
+    int thread_rounds = rounds / 10;
+    std::mutex mut;
+    std::condition_variable cv;
+    int turn = 0;
+    arrived = 0;
+    running = 2;
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&, t] {
+            if (arrived.fetch_add(1) == 1) {
+                start = bench_clock::now();
+            }
+            while (arrived.load() < 2) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < thread_rounds; ++i) {
+                std::unique_lock<std::mutex> uniq_lck(mut);
+                cv.wait(uniq_lck, [&] {return turn == t;});
+                turn = 1 - t;
+                cv.notify_one();
+            }
+            if (running.fetch_sub(1) == 1) {
+                stop = bench_clock::now();
+            }
+        });
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+    ns = std::chrono::duration<double, std::nano>(stop - start).count() / (2.0 * thread_rounds);
+    std::cout << std::left << std::setw(24) << "thread handoff" << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << ns << std::defaultfloat << std::endl;
+}
+
+void print_download_row(const std::string &kind, int flows, double ms, double mb)
+{
+    std::cout << std::left << std::setw(10) << kind << std::right << std::setw(10) << flows << std::fixed
+              << std::setprecision(1) << std::setw(12) << ms << std::setw(12) << mb << std::setw(14)
+              << mb * 1024 / flows << std::defaultfloat << std::endl;
+}
+
+void fiber_downloads(int flows)
+{
+    FiberOptions options;
+    options.stack_size = 16 * 1024;
+    options.guard_page = false;
+
+    FiberMutex mut;
+    long total_bytes {0};
+
+    reset_peak_memory();
+    auto start = bench_clock::now();
+    {
+        FiberScheduler scheduler(1, options);
+        for (int f = 0; f < flows; ++f) {
+            scheduler.spawn([&mut, &total_bytes, f] {
+                for (int block = 0; block < 5; ++block) {
+                    fiber_sleep_for(std::chrono::milliseconds(20 + (f + block) % 10));
+                    std::lock_guard<FiberMutex> lck_guard(mut);
+                    total_bytes += 6;
+                }
+            });
+        }
+    }
+    print_download_row("fibers", flows, elapsed_ms(start), peak_memory_mb());
+}
+
+void thread_downloads(int flows)
+{
+    std::mutex mut;
+    long total_bytes {0};
+
+    reset_peak_memory();
+    auto start = bench_clock::now();
+    std::vector<std::thread> threads;
+    for (int f = 0; f < flows; ++f) {
+        threads.emplace_back([&mut, &total_bytes, f] {
+            for (int block = 0; block < 5; ++block) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20 + (f + block) % 10));
+                std::lock_guard<std::mutex> lck_guard(mut);
+                total_bytes += 6;
+            }
+        });
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+    print_download_row("threads", flows, elapsed_ms(start), peak_memory_mb());
+}
+
+int main(int argc, char *argv[]) {
+    {
+        FiberScheduler scheduler(1);
+        scheduler.spawn(fetch_data);
+        scheduler.spawn(progress_bar);
+        scheduler.spawn(process_data);
+    }
+
+    int fiber_flows = argc > 1 ? std::stoi(argv[1]) : 100000;
+    int thread_flows = argc > 2 ? std::stoi(argv[2]) : 2000;
+
+    std::cout << std::endl;
+    switch_benchmark(1000000);
+
+    std::cout << "\n" << std::left << std::setw(10) << "downloads" << std::right << std::setw(10) << "flows"
+              << std::setw(12) << "ms" << std::setw(12) << "peak MB" << std::setw(14) << "KB per flow" << std::endl;
+    fiber_downloads(fiber_flows);
+    thread_downloads(thread_flows);
+
+    return 0;
+}
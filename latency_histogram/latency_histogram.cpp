@@ -0,0 +1,138 @@
+#include "latency_histogram.h"
+
+#include <algorithm>
+#include <iomanip>
+
+std::uint64_t histogram_bucket_lowest(std::size_t index)
+{
+    if (index < histogram_sub_buckets) {
+        return index;
+    }
+    std::size_t shift = index / histogram_sub_buckets - 1;
+    std::uint64_t sub_bucket = index % histogram_sub_buckets;
+    return (histogram_sub_buckets + sub_bucket) << shift;
+}
+
+std::uint64_t histogram_bucket_highest(std::size_t index)
+{
+    if (index < histogram_sub_buckets) {
+        return index;
+    }
+    std::size_t shift = index / histogram_sub_buckets - 1;
+    return histogram_bucket_lowest(index) + ((std::uint64_t{1} << shift) - 1);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other)
+{
+    for (std::size_t i = 0; i < histogram_bucket_count; ++i) {
+        counts[i] += other.counts[i];
+    }
+    total += other.total;
+    sum += other.sum;
+    min_value = other.min_value < min_value ? other.min_value : min_value;
+    max_value = other.max_value > max_value ? other.max_value : max_value;
+}
+
+void LatencyHistogram::reset()
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    min_value = UINT64_MAX;
+    max_value = 0;
+}
+
+std::uint64_t LatencyHistogram::percentile(double q) const
+{
+    if (total == 0) {
+        return 0;
+    }
+    // Rank of the sample we want, 1-based
+    std::uint64_t rank = static_cast<std::uint64_t>(q * (total - 1)) + 1;
+    std::uint64_t seen {0};
+    for (std::size_t i = 0; i < histogram_bucket_count; ++i) {
+        seen += counts[i];
+        if (seen >= rank) {
+            std::uint64_t highest = histogram_bucket_highest(i);
+            return highest < max_value ? highest : max_value;
+        }
+    }
+    return max_value;
+}
+
+void LatencyHistogram::print_summary_header(std::ostream &os, const std::string &unit)
+{
+    os << std::left << std::setw(32) << "" << std::right << std::setw(10) << "count"
+       << std::setw(12) << "p50 " + unit << std::setw(12) << "p99 " + unit
+       << std::setw(13) << "p99.9 " + unit << std::setw(12) << "max " + unit << std::endl;
+}
+
+void LatencyHistogram::print_summary(std::ostream &os, const std::string &label) const
+{
+    os << std::left << std::setw(32) << label << std::right << std::setw(10) << total
+       << std::setw(12) << percentile(0.50) << std::setw(12) << percentile(0.99)
+       << std::setw(13) << percentile(0.999) << std::setw(12) << max() << std::endl;
+}
+
+void LatencyHistogram::print(std::ostream &os) const
+{
+    for (std::size_t i = 0; i < histogram_bucket_count; ++i) {
+        if (counts[i] == 0) {
+            continue;
+        }
+        os << "    [" << std::setw(12) << histogram_bucket_lowest(i) << ", "
+           << std::setw(12) << histogram_bucket_highest(i) << "] "
+           << std::setw(8) << counts[i] << " ";
+        int bar = static_cast<int>(50 * counts[i] / total);
+        os << std::string(bar, '#') << "\n";
+    }
+}
+
+LatencyRecorder::Shard::Shard() : counts(new std::atomic<std::uint64_t>[histogram_bucket_count])
+{
+    for (std::size_t i = 0; i < histogram_bucket_count; ++i) {
+        counts[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+static std::size_t next_recorder_id()
+{
+    static std::atomic<std::size_t> next {0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+LatencyRecorder::LatencyRecorder() : id(next_recorder_id()) {}
+
+LatencyRecorder::Shard &LatencyRecorder::add_shard(std::vector<ShardRef> &table)
+{
+    // Forget the recorders which are gone
+    table.erase(std::remove_if(table.begin(), table.end(), [] (const ShardRef &ref) {
+        return ref.alive.expired();
+    }), table.end());
+
+    auto shard = std::make_shared<Shard>();
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        shards.push_back(shard);
+    }
+    table.push_back(ShardRef {id, shard.get(), shard});
+    return *shard;
+}
+
+LatencyHistogram LatencyRecorder::snapshot()
+{
+    LatencyHistogram merged;
+    std::lock_guard<std::mutex> lck_guard(mut);
+    for (auto &shard : shards) {
+        for (std::size_t i = 0; i < histogram_bucket_count; ++i) {
+            merged.counts[i] += shard->counts[i].load(std::memory_order_relaxed);
+        }
+        merged.total += shard->total.load(std::memory_order_relaxed);
+        merged.sum += shard->sum.load(std::memory_order_relaxed);
+        std::uint64_t shard_min = shard->min_value.load(std::memory_order_relaxed);
+        std::uint64_t shard_max = shard->max_value.load(std::memory_order_relaxed);
+        merged.min_value = shard_min < merged.min_value ? shard_min : merged.min_value;
+        merged.max_value = shard_max > merged.max_value ? shard_max : merged.max_value;
+    }
+    return merged;
+}
@@ -0,0 +1,168 @@
+#ifndef LATENCY_HISTOGRAM_LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_LATENCY_HISTOGRAM_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Latency Histograms
+ *
+ * - An average hides the slow operations, and the slow operations are what users notice
+ *      - A mutex that usually costs 20ns but sometimes 2ms (the owner was descheduled)
+ *      - We want p50, p99, p99.9 and max
+ *
+ * - Keeping every sample and sorting works, but costs memory and time in the measured loop
+ * - A histogram keeps a count per range of values instead
+ *      - Power-of-two buckets are cheap but coarse: p99 = "somewhere between 1 and 2 us"
+ *      - Log-linear (HdrHistogram): each power of two is split into 2^histogram_sub_bucket_bits equal parts
+ *              - With 6 bits, 64 parts, a value is known to within 1/64 = 1.6%
+ *              - Values below 128 are exact: 0-63 and 64-127 both get one bucket per value
+ *              - The whole uint64_t range fits in 59 * 64 buckets
+ *      - Finding the bucket is one count-leading-zeros and a shift, no loop
+ *
+ * - Percentiles report the highest value in the bucket, so they never understate a tail
+ *      */
+
+constexpr int histogram_sub_bucket_bits = 6;
+constexpr std::size_t histogram_sub_buckets = std::size_t{1} << histogram_sub_bucket_bits;
+constexpr std::size_t histogram_bucket_count = (64 - histogram_sub_bucket_bits + 1) * histogram_sub_buckets;
+
+inline std::size_t histogram_bucket_index(std::uint64_t value)
+{
+    if (value < histogram_sub_buckets) {
+        return static_cast<std::size_t>(value);
+    }
+    int msb = 63 - __builtin_clzll(value);
+    int shift = msb - histogram_sub_bucket_bits;
+    std::size_t sub_bucket = static_cast<std::size_t>(value >> shift) - histogram_sub_buckets;
+    return (static_cast<std::size_t>(shift) + 1) * histogram_sub_buckets + sub_bucket;
+}
+
+// Smallest and largest value which land in bucket "index"
+std::uint64_t histogram_bucket_lowest(std::size_t index);
+std::uint64_t histogram_bucket_highest(std::size_t index);
+
+// A histogram owned by one thread, or a merged snapshot
+class LatencyHistogram {
+private:
+    std::vector<std::uint64_t> counts;
+    std::uint64_t total {0};
+    std::uint64_t sum {0};
+    std::uint64_t min_value {UINT64_MAX};
+    std::uint64_t max_value {0};
+
+    friend class LatencyRecorder;
+
+public:
+    LatencyHistogram() : counts(histogram_bucket_count, 0) {}
+
+    void record(std::uint64_t value)
+    {
+        ++counts[histogram_bucket_index(value)];
+        ++total;
+        sum += value;
+        min_value = value < min_value ? value : min_value;
+        max_value = value > max_value ? value : max_value;
+    }
+
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    std::uint64_t count() const { return total; }
+    std::uint64_t min() const { return total ? min_value : 0; }
+    std::uint64_t max() const { return max_value; }
+    double mean() const { return total ? static_cast<double>(sum) / total : 0.0; }
+
+    // q in [0, 1], e.g. 0.999 for p99.9
+    std::uint64_t percentile(double q) const;
+
+    // One line: label, count, p50, p99, p99.9, max
+    // Every benchmark prints its latencies through this, so they all read the same
+    void print_summary(std::ostream &os, const std::string &label) const;
+    static void print_summary_header(std::ostream &os, const std::string &unit = "ns");
+
+    // The non-empty buckets, with a bar for each
+    void print(std::ostream &os) const;
+};
+
+/*
+ * Recording from many threads
+ * - Each thread records into its own shard, found through a thread_local table (like ObjectPool's caches)
+ * - Only the owning thread writes a shard, so a counter update is a relaxed load and store, no lock prefix
+ * - snapshot() may run at any time and merges all shards into a LatencyHistogram
+ *      - Samples recorded during the snapshot may or may not be in it
+ * - The recorder owns its shards, the threads only keep a weak reference
+ *      - A shard is freed with its recorder, not when the thread exits
+ *      - Entries of recorders which are gone are pruned when the thread meets a new recorder
+ *      */
+class LatencyRecorder {
+private:
+    struct Shard {
+        std::unique_ptr<std::atomic<std::uint64_t>[]> counts;
+        std::atomic<std::uint64_t> total {0};
+        std::atomic<std::uint64_t> sum {0};
+        std::atomic<std::uint64_t> min_value {UINT64_MAX};
+        std::atomic<std::uint64_t> max_value {0};
+
+        Shard();
+    };
+
+    struct ShardRef {
+        std::size_t recorder_id;
+        Shard *shard;                   // valid as long as that recorder is
+        std::weak_ptr<Shard> alive;     // only to find the entries to prune
+    };
+
+    std::mutex mut;
+    std::vector<std::shared_ptr<Shard>> shards;
+    std::size_t id;
+
+    Shard &my_shard()
+    {
+        // Ids are never reused, so a matching entry belongs to this recorder, which is alive: we are in it
+        thread_local std::vector<ShardRef> table;
+        for (ShardRef &ref : table) {
+            if (ref.recorder_id == id) {
+                return *ref.shard;
+            }
+        }
+        return add_shard(table);
+    }
+
+    Shard &add_shard(std::vector<ShardRef> &table);
+
+    static void bump(std::atomic<std::uint64_t> &counter, std::uint64_t by)
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+    }
+
+public:
+    LatencyRecorder();
+
+    LatencyRecorder(const LatencyRecorder &source) = delete;
+    LatencyRecorder &operator=(const LatencyRecorder &source) = delete;
+
+    void record(std::uint64_t value)
+    {
+        Shard &shard = my_shard();
+        bump(shard.counts[histogram_bucket_index(value)], 1);
+        bump(shard.total, 1);
+        bump(shard.sum, value);
+        if (value < shard.min_value.load(std::memory_order_relaxed)) {
+            shard.min_value.store(value, std::memory_order_relaxed);
+        }
+        if (value > shard.max_value.load(std::memory_order_relaxed)) {
+            shard.max_value.store(value, std::memory_order_relaxed);
+        }
+    }
+
+    LatencyHistogram snapshot();
+};
+
+#endif //LATENCY_HISTOGRAM_LATENCY_HISTOGRAM_H
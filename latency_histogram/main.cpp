@@ -0,0 +1,151 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <queue>
+#include <string>
+#include <cstdint>
+
+#include "latency_histogram.h"
+
+/*
+ * Two latency benchmarks for the primitives from working_with_shared_data
+ * - Mutex: how long does lock() take with N threads competing for it?
+ * - Queue: how long does an item sit in a mutex + condition variable queue before it is popped?
+ * - Every thread records into one LatencyRecorder, snapshot() merges them at the end
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+std::uint64_t nanoseconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count();
+}
+
+LatencyHistogram measure_lock_latency(int threads, int locks)
+{
+    std::mutex mut;
+    long shared_counter {0};
+    LatencyRecorder recorder;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < locks; ++i) {
+                auto start = bench_clock::now();
+                std::lock_guard<std::mutex> lck_guard(mut);
+                recorder.record(nanoseconds_since(start));
+                ++shared_counter;
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    return recorder.snapshot();
+}
+
+// The thread-safe queue with a condition variable, carrying push timestamps
+class TimestampQueue {
+private:
+    std::queue<bench_clock::time_point> q;
+    std::mutex m;
+    std::condition_variable cv;
+    int producers_left;
+
+public:
+    explicit TimestampQueue(int producers) : producers_left(producers) {}
+
+    void push(bench_clock::time_point val)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            q.push(val);
+        }
+        cv.notify_one();
+    }
+
+    void producer_done()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            --producers_left;
+        }
+        cv.notify_all();
+    }
+
+    bool pop(bench_clock::time_point &val)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] {return !q.empty() || producers_left == 0;});
+        if (q.empty()) {
+            return false;
+        }
+        val = q.front();
+        q.pop();
+        return true;
+    }
+};
+
+LatencyHistogram measure_queue_latency(int pairs, int items)
+{
+    TimestampQueue queue(pairs);
+    LatencyRecorder recorder;
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < pairs; ++t) {
+        workers.emplace_back([&] {
+            for (int i = 0; i < items; ++i) {
+                queue.push(bench_clock::now());
+                // A little space between items, so this measures handoff, not a backlog
+                if (i % 16 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+            queue.producer_done();
+        });
+        workers.emplace_back([&] {
+            bench_clock::time_point pushed;
+            while (queue.pop(pushed)) {
+                recorder.record(nanoseconds_since(pushed));
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    return recorder.snapshot();
+}
+
+int main(int argc, char *argv[]) {
+    // Values below 64 are exact, above that within 1/64
+    LatencyHistogram check;
+    for (std::uint64_t v = 1; v <= 1000; ++v) {
+        check.record(v * 1000);
+    }
+    std::cout << "Recorded 1000, 2000, ..., 1000000: p50 " << check.percentile(0.50) << ", p99 "
+              << check.percentile(0.99) << ", p99.9 " << check.percentile(0.999) << ", max " << check.max() << "\n\n";
+
+    int operations = argc > 1 ? std::stoi(argv[1]) : 100'000;
+    bool verbose = argc > 2 && std::string(argv[2]) == "-v";
+
+    LatencyHistogram::print_summary_header(std::cout);
+    for (int threads : {1, 2, 4, 8}) {
+        LatencyHistogram h = measure_lock_latency(threads, operations);
+        h.print_summary(std::cout, "mutex lock, " + std::to_string(threads) + " threads");
+        if (verbose) {
+            h.print(std::cout);
+        }
+    }
+    for (int pairs : {1, 2, 4}) {
+        LatencyHistogram h = measure_queue_latency(pairs, operations);
+        h.print_summary(std::cout, "queue push->pop, " + std::to_string(pairs) + " pairs");
+        if (verbose) {
+            h.print(std::cout);
+        }
+    }
+
+    return 0;
+}
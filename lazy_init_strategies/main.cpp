@@ -0,0 +1,289 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <utility>
+#include <iterator>
+#include <algorithm>
+
+#include "completion.h"
+
+using namespace std::literals;
+
+/*
+ * Lazy Initialization Strategies, Measured
+ *
+ * - local_thread_variables lists four ways to do thread-safe lazy initialization
+ *      - Naive use of a mutex
+ *      - std::call_once()
+ *      - Double-checked locking
+ *      - Meyers singleton with a static local variable
+ * - Plus one more
+ *      - Atomic pointer with acquire/release and compare-exchange, no mutex at all
+ *
+ * - Two questions for each strategy
+ *      - Fast path: how much does every call cost once the object exists?
+ *      - Init contention: how long do N threads wait when they all ask at the same time
+ *        and the object does not exist yet?
+ *      */
+
+/*
+ * Double-checked locking, done properly
+ * - The notes say C++17 fixes "ptest = new Test" so that a plain pointer is safe
+ *      - The order of new-expression steps is defined
+ *      - But reading a plain pointer while another thread writes it is still a data race
+ * - So ptest is an std::atomic<Test *>
+ *      - First check: acquire load, pairs with the release store below
+ *      - Second check under the mutex: relaxed is enough, the mutex orders it
+ *      */
+
+/*
+ * Atomic pointer with compare-exchange
+ * - Every thread that sees nullptr builds its own candidate object
+ * - compare_exchange_strong installs the first candidate
+ * - The losers delete their candidates and use the winner's
+ * - No thread ever blocks, but an expensive constructor may run several times
+ *      */
+
+// The object being lazily initialized
+// The constructor is expensive, like opening a network connection
+class Test {
+public:
+    int value;
+
+    Test() : value(42)
+    {
+        auto until = std::chrono::steady_clock::now() + 20us;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+    }
+
+    void func() {/*..... */}
+};
+
+class NaiveMutexLazy {
+    Test *ptest = nullptr;
+    std::mutex mut;
+public:
+    static constexpr const char *name = "naive mutex";
+    ~NaiveMutexLazy() { delete ptest; }
+
+    Test &get()
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (!ptest) {
+            ptest = new Test;
+        }
+        return *ptest;
+    }
+};
+
+class CallOnceLazy {
+    Test *ptest = nullptr;
+    std::once_flag ptest_flag;
+public:
+    static constexpr const char *name = "std::call_once";
+    ~CallOnceLazy() { delete ptest; }
+
+    Test &get()
+    {
+        std::call_once(ptest_flag, [this] () {
+            ptest = new Test;
+        });
+        return *ptest;
+    }
+};
+
+class DoubleCheckedLazy {
+    std::atomic<Test *> ptest {nullptr};
+    std::mutex mut;
+public:
+    static constexpr const char *name = "double-checked locking";
+    ~DoubleCheckedLazy() { delete ptest.load(); }
+
+    Test &get()
+    {
+        Test *p = ptest.load(std::memory_order_acquire); // First check of ptest
+        if (!p) {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            p = ptest.load(std::memory_order_relaxed);   // Second check of ptest
+            if (!p) {
+                p = new Test;
+                ptest.store(p, std::memory_order_release);
+            }
+        }
+        return *p;
+    }
+};
+
+// A static local can only be initialized once per program,
+// so every measurement gets its own instantiation
+template <int Tag>
+class MeyersLazy {
+public:
+    static constexpr const char *name = "Meyers singleton";
+
+    Test &get()
+    {
+        static Test test;
+        return test;
+    }
+};
+
+class AtomicPointerLazy {
+    std::atomic<Test *> ptest {nullptr};
+public:
+    static constexpr const char *name = "atomic pointer CAS";
+    ~AtomicPointerLazy() { delete ptest.load(); }
+
+    Test &get()
+    {
+        Test *p = ptest.load(std::memory_order_acquire);
+        if (!p) {
+            Test *candidate = new Test;
+            if (ptest.compare_exchange_strong(p, candidate, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                p = candidate;
+            }
+            else {
+                // Somebody else got there first, p now holds their object
+                delete candidate;
+            }
+        }
+        return *p;
+    }
+};
+
+/*
+ * Measurements
+ * - Init contention
+ *      - N threads wait on a Latch, then all call get() on an uninitialized object
+ *      - Each thread records how long its first call took
+ *      - Report the mean and the worst
+ * - Fast path
+ *      - The object already exists
+ *      - N threads call get() "calls" times each, every thread times its own loop
+ *      - Report nanoseconds per call, averaged over the threads
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+struct InitResult {
+    double mean_us;
+    double max_us;
+};
+
+template <typename Lazy>
+InitResult measure_init(Lazy &lazy, int threads)
+{
+    Latch start(threads + 1);
+    std::vector<double> waits(threads);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            start.arrive_and_wait();
+            auto before = bench_clock::now();
+            lazy.get().func();
+            waits[t] = std::chrono::duration<double, std::micro>(bench_clock::now() - before).count();
+        });
+    }
+    start.arrive_and_wait();
+    for (auto &thr : workers) {
+        thr.join();
+    }
+
+    double total {0};
+    for (double w : waits) {
+        total += w;
+    }
+    return {total / threads, *std::max_element(waits.begin(), waits.end())};
+}
+
+template <typename Lazy>
+double measure_fast_path(Lazy &lazy, int threads, long calls)
+{
+    lazy.get();
+
+    Latch start(threads);
+    std::vector<double> ns_per_call(threads);
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            start.arrive_and_wait();
+            long sink {0};
+            auto before = bench_clock::now();
+            for (long i = 0; i < calls; ++i) {
+                sink += lazy.get().value;
+            }
+            auto elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - before).count();
+            ns_per_call[t] = elapsed / calls;
+
+            volatile long keep = sink;
+            (void)keep;
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+
+    double total {0};
+    for (double ns : ns_per_call) {
+        total += ns;
+    }
+    return total / threads;
+}
+
+const int thread_counts[] = {1, 2, 4, 8, 16, 32, 64};
+
+void print_row(const char *name, int threads, InitResult init, double fast_ns)
+{
+    std::cout << std::left << std::setw(24) << name << std::right << std::setw(8) << threads
+              << std::setw(14) << init.mean_us << std::setw(14) << init.max_us
+              << std::setw(14) << fast_ns << std::endl;
+}
+
+template <typename Lazy>
+void run_strategy(long calls)
+{
+    for (int threads : thread_counts) {
+        // A fresh object each time, so the init measurement really is the first call
+        Lazy for_init;
+        InitResult init = measure_init(for_init, threads);
+        Lazy for_fast_path;
+        print_row(Lazy::name, threads, init, measure_fast_path(for_fast_path, threads, calls));
+    }
+}
+
+// Meyers needs a new instantiation for every fresh static
+template <int... Index>
+void run_meyers(long calls, std::integer_sequence<int, Index...>)
+{
+    ((void) [calls] {
+        const int threads = thread_counts[Index];
+        MeyersLazy<2 * Index> for_init;
+        InitResult init = measure_init(for_init, threads);
+        MeyersLazy<2 * Index + 1> for_fast_path;
+        print_row(MeyersLazy<0>::name, threads, init, measure_fast_path(for_fast_path, threads, calls));
+    }(), ...);
+}
+
+int main(int argc, char *argv[]) {
+    long calls = argc > 1 ? std::stol(argv[1]) : 200'000;
+
+    std::cout << std::left << std::setw(24) << "strategy" << std::right << std::setw(8) << "threads"
+              << std::setw(14) << "init mean us" << std::setw(14) << "init max us"
+              << std::setw(14) << "fast ns/call" << std::endl;
+
+    run_strategy<NaiveMutexLazy>(calls);
+    run_strategy<CallOnceLazy>(calls);
+    run_strategy<DoubleCheckedLazy>(calls);
+    run_meyers(calls, std::make_integer_sequence<int, std::size(thread_counts)>{});
+    run_strategy<AtomicPointerLazy>(calls);
+
+    return 0;
+}
@@ -0,0 +1,154 @@
+#ifndef LAZY_INIT_TEMPLATE_LAZY_INIT_H
+#define LAZY_INIT_TEMPLATE_LAZY_INIT_H
+
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+#include "futex.h"
+
+/*
+ * LazyInit<T>
+ *
+ * - process() and Singleton::instance() in local_thread_variables
+ *      - Call std::call_once() on every call, even long after the object exists
+ *      - Allocate the object with new, and never delete it
+ *
+ * - LazyInit<T> keeps the object inside itself
+ *      - No heap allocation, no pointer to follow
+ * - A state word says whether the object exists
+ *      - empty        : nobody has built it yet
+ *      - constructing : one thread is running the constructor
+ *      - ready        : built, everyone can use it
+ * - Fast path: one acquire load of the state word, then use the object
+ *      - On x86 an acquire load is an ordinary mov instruction
+ * - Slow path
+ *      - compare-exchange empty -> constructing decides which thread builds it
+ *      - Everybody else sleeps on the state word (futex) until it changes
+ *
+ * - If the constructor throws
+ *      - The state goes back to empty and the sleepers are woken
+ *      - The exception goes to the thread that was building it
+ *      - The next caller tries again, just like std::call_once()
+ *
+ * - reset() destroys the object at a time of our choosing
+ *      - The caller must make sure no other thread is still using it
+ *      - The destructor of LazyInit calls reset()
+ *      */
+
+template <typename T>
+class LazyInit {
+private:
+    enum : std::uint32_t { empty = 0, constructing = 1, ready = 2 };
+
+    std::atomic<std::uint32_t> state {empty};
+    std::atomic<std::uint32_t> sleepers {0};
+    alignas(T) unsigned char storage[sizeof(T)];
+
+    T *object()
+    {
+        return std::launder(reinterpret_cast<T *>(storage));
+    }
+
+    // Kept out of line so that get() inlines down to the load and the branch
+    template <typename Construct>
+    [[gnu::noinline]] T &init_slow(Construct &&construct)
+    {
+        while (true) {
+            std::uint32_t s = state.load(std::memory_order_acquire);
+            if (s == ready) {
+                return *object();
+            }
+
+            if (s == empty) {
+                if (!state.compare_exchange_strong(s, constructing, std::memory_order_acquire)) {
+                    continue;
+                }
+                try {
+                    construct(static_cast<void *>(storage));
+                }
+                catch (...) {
+                    publish(empty);
+                    throw;
+                }
+                publish(ready);
+                return *object();
+            }
+
+            // Somebody else is constructing it
+            sleepers.fetch_add(1, std::memory_order_seq_cst);
+            if (state.load(std::memory_order_seq_cst) == constructing) {
+                futex_wait(state, constructing);
+            }
+            sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void publish(std::uint32_t new_state)
+    {
+        // The release makes the constructed object visible to the acquire load in get()
+        state.store(new_state, std::memory_order_seq_cst);
+        if (sleepers.load(std::memory_order_seq_cst) != 0) {
+            futex_wake_all(state);
+        }
+    }
+
+public:
+    LazyInit() = default;
+
+    LazyInit(const LazyInit &source) = delete;
+    LazyInit &operator=(const LazyInit &source) = delete;
+
+    ~LazyInit()
+    {
+        reset();
+    }
+
+    // The first caller's arguments are passed to T's constructor, later arguments are ignored
+    template <typename... Args>
+    T &get(Args &&... args)
+    {
+        if (state.load(std::memory_order_acquire) == ready) {
+            return *object();
+        }
+        return init_slow([&args...] (void *where) {
+            new (where) T(std::forward<Args>(args)...);
+        });
+    }
+
+    // Build the object from whatever factory() returns (guaranteed copy elision, no move needed)
+    template <typename Factory>
+    T &get_with(Factory &&factory)
+    {
+        if (state.load(std::memory_order_acquire) == ready) {
+            return *object();
+        }
+        return init_slow([&factory] (void *where) {
+            new (where) T(factory());
+        });
+    }
+
+    bool is_ready() const
+    {
+        return state.load(std::memory_order_acquire) == ready;
+    }
+
+    // Returns nullptr if the object has not been built
+    T *try_get()
+    {
+        return is_ready() ? object() : nullptr;
+    }
+
+    // Destroy the object now, the next get() builds a new one
+    // Not thread-safe: no other thread may be using the object or calling get()
+    void reset()
+    {
+        if (state.load(std::memory_order_acquire) == ready) {
+            object()->~T();
+            state.store(empty, std::memory_order_release);
+        }
+    }
+};
+
+#endif //LAZY_INIT_TEMPLATE_LAZY_INIT_H
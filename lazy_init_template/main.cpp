@@ -0,0 +1,156 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <stdexcept>
+
+#include "lazy_init.h"
+
+using namespace std::literals;
+
+// The object being lazily initialized
+class Test {
+public:
+    std::string host;
+    int port;
+
+    // Fails the first time, like a network connection that is not up yet
+    static std::atomic<int> attempts;
+
+    Test(std::string host, int port) : host(std::move(host)), port(port)
+    {
+        if (attempts.fetch_add(1) == 0) {
+            throw std::runtime_error("connection refused");
+        }
+        std::this_thread::sleep_for(10ms);
+        std::cout << "Connected to " << this->host << ":" << this->port << std::endl;
+    }
+
+    ~Test()
+    {
+        std::cout << "Closed " << host << ":" << port << std::endl;
+    }
+
+    void func() {/*..... */}
+};
+
+std::atomic<int> Test::attempts {0};
+
+LazyInit<Test> ptest; // Variable to be lazily initialized
+
+void process()
+{
+    try {
+        ptest.get("localhost", 8080).func();
+    }
+    catch (const std::exception &e) {
+        std::cout << "process() failed: " << e.what() << std::endl;
+    }
+}
+
+/*
+ * Singleton with LazyInit
+ * - instance_ lives in static storage, no new and no leak
+ * - Nothing else to declare and define outside the class
+ *      */
+class Singleton {
+public:
+    static Singleton &instance()
+    {
+        return instance_.get_with([] {return Singleton();});
+    }
+
+    int value() const {return 24;}
+
+private:
+    Singleton() = default; // constructor
+    static LazyInit<Singleton> instance_;
+};
+
+LazyInit<Singleton> Singleton::instance_;
+
+/*
+ * Fast path benchmark
+ * - Baseline: a relaxed load of an std::atomic<Counter *>
+ *      - Compiles to the same mov as a plain load, but the compiler cannot hoist it out of the loop
+ * - Compared with LazyInit<T>::get(), std::call_once() and a Meyers singleton
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+struct Counter {
+    long value = 1;
+};
+
+template <typename Get>
+double ns_per_call(long calls, Get get)
+{
+    long sink {0};
+    auto before = bench_clock::now();
+    for (long i = 0; i < calls; ++i) {
+        sink += get().value;
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(bench_clock::now() - before).count();
+    volatile long keep = sink;
+    (void)keep;
+    return elapsed / calls;
+}
+
+void benchmark(long calls)
+{
+    static Counter counter;
+    static std::atomic<Counter *> plain {&counter};
+
+    static LazyInit<Counter> lazy;
+    lazy.get();
+
+    static Counter *pcounter = nullptr;
+    static std::once_flag counter_flag;
+
+    // Initialized from a volatile so it needs a run-time guard, like a real Meyers singleton
+    static volatile long one = 1;
+    auto meyers = [] () -> Counter & {
+        static Counter c {one};
+        return c;
+    };
+
+    std::cout << "\nFast path over " << calls << " calls, ns per call" << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "plain load" << std::right
+              << ns_per_call(calls, [] () -> Counter & {return *plain.load(std::memory_order_relaxed);}) << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "LazyInit::get()" << std::right
+              << ns_per_call(calls, [] () -> Counter & {return lazy.get();}) << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "std::call_once" << std::right
+              << ns_per_call(calls, [] () -> Counter & {
+                     std::call_once(counter_flag, [] {pcounter = new Counter;});
+                     return *pcounter;
+                 }) << std::endl;
+    std::cout << "  " << std::left << std::setw(22) << "Meyers singleton" << std::right
+              << ns_per_call(calls, meyers) << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    // The first builder throws, the others wait and then one of them retries
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back(process);
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+    std::cout << "Constructor ran " << Test::attempts << " times" << std::endl;
+
+    std::cout << "Singleton value: " << Singleton::instance().value() << std::endl;
+
+    // Deterministic destruction: the connection closes here, not at exit
+    ptest.reset();
+    std::cout << "After reset(), ready = " << std::boolalpha << ptest.is_ready() << std::endl;
+
+    long calls = argc > 1 ? std::stol(argv[1]) : 100'000'000;
+    benchmark(calls);
+
+    return 0;
+}
@@ -229,6 +229,11 @@ private:
     Singleton &operator=(Singleton &&soure) = delete;
 };
 
+// Static data members need a definition outside the class
+// (see lazy_init_template for a version which does not leak instance_)
+Singleton *Singleton::instance_ = nullptr;
+std::once_flag Singleton::init;
+
 
 static int &number1() {
     static int num1 {23};
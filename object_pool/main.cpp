@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <queue>
+#include <string>
+
+#include "object_pool.h"
+
+/*
+ * The objects from the examples
+ * - Test, as allocated by process() in local_thread_variables
+ * - Node, as a thread-safe queue would allocate one per element
+ *      */
+
+class Test {
+public:
+    int value;
+    explicit Test(int value) : value(value) {}
+    void func() {/*..... */}
+};
+
+struct Node {
+    int value;
+    Node *next;
+    char payload[48];
+};
+
+/*
+ * A queue of batches between producers and consumers
+ * - Producers allocate Nodes and push them in batches of 256
+ * - Consumers pop a batch and free every Node in it
+ * - Every Node is allocated on one thread and freed on another
+ *      */
+class BatchQueue {
+private:
+    std::queue<std::vector<Node *>> q;
+    std::mutex m;
+    std::condition_variable cv;
+    int producers_left;
+
+public:
+    explicit BatchQueue(int producers) : producers_left(producers) {}
+
+    void push(std::vector<Node *> batch)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            q.push(std::move(batch));
+        }
+        cv.notify_one();
+    }
+
+    void producer_done()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            --producers_left;
+        }
+        cv.notify_all();
+    }
+
+    // Returns false when all producers are done and the queue is empty
+    bool pop(std::vector<Node *> &batch)
+    {
+        std::unique_lock<std::mutex> lock(m);
+        cv.wait(lock, [this] {return !q.empty() || producers_left == 0;});
+        if (q.empty()) {
+            return false;
+        }
+        batch = std::move(q.front());
+        q.pop();
+        return true;
+    }
+};
+
+using bench_clock = std::chrono::steady_clock;
+
+// Every thread allocates and frees on its own: the pure allocation rate
+template <typename Alloc, typename Free>
+double same_thread_rate(int threads, long objects, Alloc alloc, Free release)
+{
+    std::vector<std::thread> workers;
+    auto start = bench_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&] {
+            std::vector<Node *> live(128);
+            for (long i = 0; i < objects; i += 128) {
+                for (auto &p : live) {
+                    p = alloc();
+                }
+                for (auto &p : live) {
+                    release(p);
+                }
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return threads * objects / seconds / 1e6;
+}
+
+// Producers allocate, consumers free: every object crosses threads
+template <typename Alloc, typename Free>
+double cross_thread_rate(int pairs, long objects, Alloc alloc, Free release)
+{
+    BatchQueue queue(pairs);
+    std::vector<std::thread> workers;
+    auto start = bench_clock::now();
+    for (int t = 0; t < pairs; ++t) {
+        workers.emplace_back([&] {
+            for (long i = 0; i < objects; i += 256) {
+                std::vector<Node *> batch(256);
+                for (auto &p : batch) {
+                    p = alloc();
+                }
+                queue.push(std::move(batch));
+            }
+            queue.producer_done();
+        });
+        workers.emplace_back([&] {
+            std::vector<Node *> batch;
+            while (queue.pop(batch)) {
+                for (Node *p : batch) {
+                    release(p);
+                }
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return pairs * objects / seconds / 1e6;
+}
+
+void benchmark(long objects)
+{
+    ObjectPool<Node> pool;
+    auto pool_alloc = [&pool] {return pool.create();};
+    auto pool_free = [&pool] (Node *p) {pool.destroy(p);};
+    auto heap_alloc = [] {return new Node;};
+    auto heap_free = [] (Node *p) {delete p;};
+
+    std::cout << "\nMillion allocations per second, " << sizeof(Node) << "-byte objects" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "new/delete" << std::setw(14) << "ObjectPool"
+              << std::setw(20) << "x-thread new" << std::setw(18) << "x-thread pool" << std::endl;
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::cout << std::setw(8) << threads
+                  << std::setw(14) << same_thread_rate(threads, objects, heap_alloc, heap_free)
+                  << std::setw(14) << same_thread_rate(threads, objects, pool_alloc, pool_free)
+                  << std::setw(20) << cross_thread_rate(threads, objects, heap_alloc, heap_free)
+                  << std::setw(18) << cross_thread_rate(threads, objects, pool_alloc, pool_free) << std::endl;
+    }
+    std::cout << "Pool capacity after the benchmark: " << pool.capacity() << " objects" << std::endl;
+}
+
+int main(int argc, char *argv[]) {
+    ObjectPool<Test> tests;
+
+    // Allocated on one thread...
+    Test *ptest = nullptr;
+    std::thread maker([&] {ptest = tests.create(42);});
+    maker.join();
+
+    // ...freed on another
+    std::thread user([&] {
+        ptest->func();
+        std::cout << "Test value " << ptest->value << std::endl;
+        tests.destroy(ptest);
+    });
+    user.join();
+
+    long objects = argc > 1 ? std::stol(argv[1]) : 500'000;
+    benchmark(objects);
+
+    return 0;
+}
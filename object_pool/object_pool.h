@@ -0,0 +1,287 @@
+#ifndef OBJECT_POOL_OBJECT_POOL_H
+#define OBJECT_POOL_OBJECT_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/*
+ * Fixed-size Object Pool with Per-thread Caches
+ *
+ * - process() does "new Test", a thread-safe queue allocates a node per push
+ *      - Every object is the same size
+ *      - The global heap does not know that, and has to be ready for any size
+ *
+ * - A pool hands out slots which are exactly the size of one T
+ *      - Slots are carved out of big slabs
+ *      - A free slot is remembered by pointer, so reuse is just a pop
+ *
+ * - Magazines (after Bonwick's slab allocator)
+ *      - A magazine is a small stack of free slot pointers (64 here)
+ *      - Each thread has two magazines for each pool: "loaded" and "previous"
+ *              - allocate pops from loaded, deallocate pushes onto loaded
+ *              - If loaded is empty/full, swap it with previous and try again
+ *      - Only when both are empty/full does the thread go to the depot
+ *      - The thread-local magazines need no locking at all
+ *
+ * - The depot
+ *      - Shared by all threads, protected by a mutex
+ *      - Holds full magazines and empty magazines
+ *              - "full" here means "has something in it", which is all allocate() needs
+ *      - A thread which frees more than it allocates hands over full magazines
+ *      - A thread which allocates more than it frees picks them up
+ *      - So memory flows from consumers back to producers, 64 objects at a time
+ *
+ * - Cross-thread free
+ *      - Object allocated by thread A, destroyed by thread B (producer/consumer queue)
+ *      - All slots in a pool are interchangeable, so B puts it into its own magazine
+ *      - It gets back to A through the depot
+ *
+ * - Lifetime
+ *      - The pool owns the depot and the slabs, a thread cache only has a std::weak_ptr to the depot
+ *      - When a thread exits, its cached magazines go back to the depot, if the pool is still there
+ *      - The slabs are freed with the pool
+ *              - A thread's cache of a dead pool is pruned the next time that thread meets a new pool
+ *      - Destroying the pool while objects are still in use is an error
+ *      */
+
+constexpr std::size_t pool_magazine_size = 64;
+
+// Thread caches for every pool live in one thread_local table, looked up by pool id
+// Ids are never reused, so an entry with a live pool's id really is that pool's cache
+class PoolCacheBase {
+public:
+    virtual ~PoolCacheBase() = default;
+    // True once the pool is gone
+    virtual bool expired() const = 0;
+};
+
+struct PoolCacheEntry {
+    std::size_t pool_id;
+    std::unique_ptr<PoolCacheBase> cache;
+};
+
+inline std::vector<PoolCacheEntry> &pool_cache_table()
+{
+    thread_local std::vector<PoolCacheEntry> table;
+    return table;
+}
+
+inline std::size_t next_pool_id()
+{
+    static std::atomic<std::size_t> next {0};
+    return next.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <typename T>
+class ObjectPool {
+private:
+    struct Slot {
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    struct Magazine {
+        std::size_t count = 0;
+        Slot *slots[pool_magazine_size];
+
+        bool empty() const { return count == 0; }
+        bool full() const { return count == pool_magazine_size; }
+    };
+
+    struct Depot {
+        std::mutex mut;
+        std::vector<std::unique_ptr<Magazine>> full;
+        std::vector<std::unique_ptr<Magazine>> empty;
+        std::vector<std::unique_ptr<Slot[]>> slabs;
+        std::size_t slab_objects;
+
+        // A full magazine, taken from the depot or carved from a new slab
+        std::unique_ptr<Magazine> take_full(std::unique_ptr<Magazine> give_back_empty)
+        {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            if (give_back_empty) {
+                empty.push_back(std::move(give_back_empty));
+            }
+            if (!full.empty()) {
+                std::unique_ptr<Magazine> magazine = std::move(full.back());
+                full.pop_back();
+                return magazine;
+            }
+
+            // Nothing free anywhere: grow by one slab
+            slabs.emplace_back(new Slot[slab_objects]);
+            Slot *slab = slabs.back().get();
+            for (std::size_t i = pool_magazine_size; i < slab_objects; i += pool_magazine_size) {
+                full.push_back(load_magazine(slab + i));
+            }
+            return load_magazine(slab);
+        }
+
+        // An empty magazine, taken from the depot or newly allocated
+        std::unique_ptr<Magazine> take_empty(std::unique_ptr<Magazine> give_back_full)
+        {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            if (give_back_full) {
+                full.push_back(std::move(give_back_full));
+            }
+            if (!empty.empty()) {
+                std::unique_ptr<Magazine> magazine = std::move(empty.back());
+                empty.pop_back();
+                return magazine;
+            }
+            return std::make_unique<Magazine>();
+        }
+
+        // A thread cache is going away
+        // Any magazine with something in it counts as "full", allocate() only needs it non-empty
+        void give_back(std::unique_ptr<Magazine> magazine)
+        {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            if (magazine->empty()) {
+                empty.push_back(std::move(magazine));
+            }
+            else {
+                full.push_back(std::move(magazine));
+            }
+        }
+
+        static std::unique_ptr<Magazine> load_magazine(Slot *first)
+        {
+            auto magazine = std::make_unique<Magazine>();
+            for (std::size_t i = 0; i < pool_magazine_size; ++i) {
+                magazine->slots[i] = first + i;
+            }
+            magazine->count = pool_magazine_size;
+            return magazine;
+        }
+    };
+
+    class ThreadCache : public PoolCacheBase {
+    public:
+        std::weak_ptr<Depot> depot;
+        std::unique_ptr<Magazine> loaded;
+        std::unique_ptr<Magazine> previous;
+
+        explicit ThreadCache(const std::shared_ptr<Depot> &depot)
+            : depot(depot), loaded(std::make_unique<Magazine>()), previous(std::make_unique<Magazine>()) {}
+
+        ~ThreadCache() override
+        {
+            // The thread is exiting, hand everything back
+            // If the pool is gone, the slots went with it and the magazines are just freed
+            if (std::shared_ptr<Depot> alive = depot.lock()) {
+                alive->give_back(std::move(loaded));
+                alive->give_back(std::move(previous));
+            }
+        }
+
+        bool expired() const override
+        {
+            return depot.expired();
+        }
+    };
+
+    std::shared_ptr<Depot> depot;
+    std::size_t id;
+
+    ThreadCache &cache()
+    {
+        auto &table = pool_cache_table();
+        for (PoolCacheEntry &entry : table) {
+            if (entry.pool_id == id) {
+                return static_cast<ThreadCache &>(*entry.cache);
+            }
+        }
+
+        // First use of this pool on this thread: drop the caches of pools which are gone
+        table.erase(std::remove_if(table.begin(), table.end(), [] (const PoolCacheEntry &entry) {
+            return entry.cache->expired();
+        }), table.end());
+        table.push_back(PoolCacheEntry {id, std::make_unique<ThreadCache>(depot)});
+        return static_cast<ThreadCache &>(*table.back().cache);
+    }
+
+public:
+    // Each slab holds "slab_magazines" magazines worth of objects
+    // Throws std::invalid_argument for 0, a slab would have no room for anything
+    explicit ObjectPool(std::size_t slab_magazines = 16)
+        : depot(std::make_shared<Depot>()), id(next_pool_id())
+    {
+        if (slab_magazines == 0) {
+            throw std::invalid_argument("ObjectPool needs at least one magazine per slab");
+        }
+        depot->slab_objects = slab_magazines * pool_magazine_size;
+    }
+
+    ObjectPool(const ObjectPool &source) = delete;
+    ObjectPool &operator=(const ObjectPool &source) = delete;
+
+    // Raw memory for one T
+    void *allocate()
+    {
+        ThreadCache &c = cache();
+        if (c.loaded->empty()) {
+            if (!c.previous->empty()) {
+                std::swap(c.loaded, c.previous);
+            }
+            else {
+                // Both empty: swap an empty one for a full one at the depot
+                c.previous = depot->take_full(std::move(c.previous));
+                std::swap(c.loaded, c.previous);
+            }
+        }
+        return c.loaded->slots[--c.loaded->count];
+    }
+
+    void deallocate(void *p)
+    {
+        ThreadCache &c = cache();
+        if (c.loaded->full()) {
+            if (!c.previous->full()) {
+                std::swap(c.loaded, c.previous);
+            }
+            else {
+                // Both full: swap a full one for an empty one at the depot
+                c.previous = depot->take_empty(std::move(c.previous));
+                std::swap(c.loaded, c.previous);
+            }
+        }
+        c.loaded->slots[c.loaded->count++] = static_cast<Slot *>(p);
+    }
+
+    template <typename... Args>
+    T *create(Args &&... args)
+    {
+        void *p = allocate();
+        try {
+            return new (p) T(std::forward<Args>(args)...);
+        }
+        catch (...) {
+            deallocate(p);
+            throw;
+        }
+    }
+
+    // May be called from any thread, not just the one which created the object
+    void destroy(T *object)
+    {
+        object->~T();
+        deallocate(object);
+    }
+
+    // Objects' worth of memory the pool has taken from the heap
+    std::size_t capacity()
+    {
+        std::lock_guard<std::mutex> lck_guard(depot->mut);
+        return depot->slabs.size() * depot->slab_objects;
+    }
+};
+
+#endif //OBJECT_POOL_OBJECT_POOL_H
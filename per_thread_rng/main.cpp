@@ -0,0 +1,133 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "rng.h"
+
+/*
+ * Reproducible streams
+ * - Worker i binds stream i before it draws anything
+ * - Run the program twice with the same seed: the same worker prints the same numbers
+ * - Different workers print different numbers
+ *
+ * - Do not mix bind_thread_rng() with automatic indices in one run
+ *      - An automatic index could pick a stream which a worker binds explicitly
+ *      */
+
+std::mutex print_mut;
+
+void func(int worker)
+{
+    bind_thread_rng(worker);
+    std::uniform_real_distribution<double> dist(0, 1); // Doubles in the range 0 - 1
+
+    std::string line = "Worker " + std::to_string(worker) + ": ";
+    for (int i = 0; i < 5; ++i) {
+        line += std::to_string(dist(thread_rng())) + ", ";
+    }
+    std::lock_guard<std::mutex> print(print_mut);
+    std::cout << line << std::endl;
+}
+
+/*
+ * Throughput benchmark
+ * - Each thread draws "count" numbers from its own engine
+ * - Measure numbers per second
+ * - Keep a running sum so the compiler cannot throw the work away
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename MakeEngine, typename Draw>
+double throughput(int threads, std::uint64_t count, MakeEngine make_engine, Draw draw)
+{
+    std::vector<std::thread> workers;
+    std::vector<double> sinks(threads);
+
+    auto start = bench_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            auto engine = make_engine(t);
+            double sink {0};
+            for (std::uint64_t i = 0; i < count; ++i) {
+                sink += draw(engine);
+            }
+            sinks[t] = sink;
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    volatile double keep = 0;
+    for (double s : sinks) {
+        keep = keep + s;
+    }
+    return threads * count / seconds / 1e6;
+}
+
+void benchmark(std::uint64_t count)
+{
+    const int max_threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+
+    std::cout << "\nState per thread: std::mt19937 " << sizeof(std::mt19937)
+              << " bytes, std::mt19937_64 " << sizeof(std::mt19937_64)
+              << " bytes, Xoshiro256StarStar " << sizeof(Xoshiro256StarStar) << " bytes" << std::endl;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::cout << "\n" << threads << " thread(s), million numbers per second" << std::endl;
+
+        std::cout << "  mt19937_64 raw                 "
+                  << throughput(threads, count,
+                                [] (int t) {return std::mt19937_64(t);},
+                                [] (std::mt19937_64 &e) {return static_cast<double>(e());}) << std::endl;
+        std::cout << "  xoshiro256** raw               "
+                  << throughput(threads, count,
+                                [] (int t) {return make_rng_stream(1, t);},
+                                [] (Xoshiro256StarStar &e) {return static_cast<double>(e());}) << std::endl;
+
+        std::cout << "  mt19937 + uniform_real         "
+                  << throughput(threads, count,
+                                [] (int t) {return std::mt19937(t);},
+                                [] (std::mt19937 &e) {
+                                    std::uniform_real_distribution<double> dist(0, 1);
+                                    return dist(e);
+                                }) << std::endl;
+        std::cout << "  xoshiro256** + uniform_real    "
+                  << throughput(threads, count,
+                                [] (int t) {return make_rng_stream(1, t);},
+                                [] (Xoshiro256StarStar &e) {
+                                    std::uniform_real_distribution<double> dist(0, 1);
+                                    return dist(e);
+                                }) << std::endl;
+        std::cout << "  xoshiro256** + to_unit_double  "
+                  << throughput(threads, count,
+                                [] (int t) {return make_rng_stream(1, t);},
+                                [] (Xoshiro256StarStar &e) {return to_unit_double(e());}) << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::uint64_t seed = argc > 1 ? std::stoull(argv[1]) : 2024;
+    set_rng_seed(seed);
+    std::cout << "Global seed " << seed << std::endl;
+
+    std::vector<std::thread> workers;
+    for (int i = 0; i < 4; ++i) {
+        workers.emplace_back(func, i);
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+
+    std::uint64_t count = argc > 2 ? std::stoull(argv[2]) : 20'000'000;
+    benchmark(count);
+
+    return 0;
+}
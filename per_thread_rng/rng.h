@@ -0,0 +1,199 @@
+#ifndef PER_THREAD_RNG_RNG_H
+#define PER_THREAD_RNG_RNG_H
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+/*
+ * Per-thread Random Number Engines
+ *
+ * - In local_thread_variables we wrote
+ *      thread_local std::mt19937 mt;
+ * - Every thread gets its own engine, so there is no data race
+ * - But every engine is default-constructed with the same seed
+ *      - Every thread generates exactly the same sequence
+ * - And std::mt19937 carries about 5 KB of state per thread
+ *      */
+
+/*
+ * xoshiro256**
+ * - 32 bytes of state, a handful of shifts, rotates and one multiply per number
+ * - Passes the usual statistical test suites
+ * - It has a jump() function
+ *      - Equivalent to calling the engine 2^128 times
+ *      - Costs about the same as 256 calls
+ * - Stream k = the seeded engine jumped k times
+ *      - Every stream is a separate 2^128 long piece of one big sequence
+ *      - The streams can never overlap
+ *      - Same global seed and same stream index => same numbers, on any run
+ *      */
+
+/*
+ * SplitMix64
+ * - Used to turn one 64-bit seed into the 256 bits of xoshiro state
+ * - Nearby seeds (1, 2, 3...) give completely unrelated states
+ *      */
+inline std::uint64_t splitmix64(std::uint64_t &state)
+{
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+class Xoshiro256StarStar {
+private:
+    std::uint64_t s[4];
+
+    static std::uint64_t rotl(std::uint64_t x, int k)
+    {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    void apply_jump(const std::uint64_t (&table)[4])
+    {
+        std::uint64_t t[4] {0, 0, 0, 0};
+        for (std::uint64_t word : table) {
+            for (int b = 0; b < 64; ++b) {
+                if (word & (std::uint64_t{1} << b)) {
+                    for (int i = 0; i < 4; ++i) {
+                        t[i] ^= s[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            s[i] = t[i];
+        }
+    }
+
+public:
+    // Satisfies UniformRandomBitGenerator, so it works with the <random> distributions
+    using result_type = std::uint64_t;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    explicit Xoshiro256StarStar(std::uint64_t seed = 0)
+    {
+        for (auto &word : s) {
+            word = splitmix64(seed);
+        }
+    }
+
+    result_type operator()()
+    {
+        const std::uint64_t result = rotl(s[1] * 5, 7) * 9;
+        const std::uint64_t t = s[1] << 17;
+
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+
+        return result;
+    }
+
+    // Advance by 2^128 calls
+    void jump()
+    {
+        static constexpr std::uint64_t table[4] {
+            0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL
+        };
+        apply_jump(table);
+    }
+
+    // Advance by 2^192 calls, for splitting the streams into groups
+    void long_jump()
+    {
+        static constexpr std::uint64_t table[4] {
+            0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL
+        };
+        apply_jump(table);
+    }
+};
+
+// Stream number "stream_id" of the sequence started by "seed"
+inline Xoshiro256StarStar make_rng_stream(std::uint64_t seed, std::uint64_t stream_id)
+{
+    Xoshiro256StarStar rng(seed);
+    for (std::uint64_t i = 0; i < stream_id; ++i) {
+        rng.jump();
+    }
+    return rng;
+}
+
+// Uniform double in [0, 1) from the top 53 bits, exactly like a 53-bit mantissa
+inline double to_unit_double(std::uint64_t x)
+{
+    return static_cast<double>(x >> 11) * 0x1.0p-53;
+}
+
+/*
+ * The thread-local engine
+ * - Seeded from one global seed plus a per-thread stream index
+ * - By default the index is handed out in the order threads first use thread_rng()
+ *      - That order depends on the scheduler
+ * - For reproducible runs, call bind_thread_rng(i) at the start of worker i
+ *      - Worker i then always gets stream i, whatever order the threads start in
+ *      */
+
+inline std::atomic<std::uint64_t> &rng_global_seed()
+{
+    static std::atomic<std::uint64_t> seed {0x5eed5eed5eed5eedULL};
+    return seed;
+}
+
+inline std::atomic<std::uint64_t> &rng_next_stream()
+{
+    static std::atomic<std::uint64_t> next {0};
+    return next;
+}
+
+// Call before starting any threads
+inline void set_rng_seed(std::uint64_t seed)
+{
+    rng_global_seed().store(seed, std::memory_order_relaxed);
+    rng_next_stream().store(0, std::memory_order_relaxed);
+}
+
+struct ThreadRngSlot {
+    bool bound = false;
+    std::uint64_t stream_id = 0;
+    Xoshiro256StarStar engine;
+};
+
+inline ThreadRngSlot &thread_rng_slot()
+{
+    thread_local ThreadRngSlot slot;
+    return slot;
+}
+
+inline void bind_thread_rng(std::uint64_t stream_id)
+{
+    ThreadRngSlot &slot = thread_rng_slot();
+    slot.engine = make_rng_stream(rng_global_seed().load(std::memory_order_relaxed), stream_id);
+    slot.stream_id = stream_id;
+    slot.bound = true;
+}
+
+inline Xoshiro256StarStar &thread_rng()
+{
+    ThreadRngSlot &slot = thread_rng_slot();
+    if (!slot.bound) {
+        bind_thread_rng(rng_next_stream().fetch_add(1, std::memory_order_relaxed));
+    }
+    return slot.engine;
+}
+
+inline std::uint64_t thread_rng_stream()
+{
+    thread_rng();
+    return thread_rng_slot().stream_id;
+}
+
+#endif //PER_THREAD_RNG_RNG_H
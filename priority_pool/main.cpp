@@ -0,0 +1,162 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <vector>
+#include <algorithm>
+
+#include "priority_pool.h"
+#include "latency_histogram.h"
+
+using namespace std::literals;
+
+/*
+ * The fetch loop from thread_synchronization as batch work, with requests arriving meanwhile
+ * - 6 blocks of 100ms each on 2 workers: the batch lane is full for 300ms
+ * - The requests arrive 50ms later, and start as soon as a worker is free (100ms)
+ *      - In one FIFO queue they would wait for all 6 blocks (300ms)
+ *      */
+
+std::mutex print_mut;
+auto demo_start = std::chrono::steady_clock::now();
+
+void print(const std::string &line)
+{
+    auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - demo_start);
+    std::lock_guard<std::mutex> lck_guard(print_mut);
+    std::cout << ms.count() << "ms: " << line << std::endl;
+}
+
+void download_example()
+{
+    PriorityPool pool(2);
+    demo_start = std::chrono::steady_clock::now();
+    for (int i = 0; i < 6; ++i) {
+        pool.submit(Priority::low, [i] {
+            print("Fetching Block" + std::to_string(i + 1));
+            std::this_thread::sleep_for(100ms);
+        });
+    }
+    std::this_thread::sleep_for(50ms);
+    for (int i = 0; i < 2; ++i) {
+        pool.submit(Priority::high, [i] {print("Answering request " + std::to_string(i + 1));});
+    }
+}
+
+/*
+ * Benchmark: latency of high-priority tasks while the low lane is saturated
+ * - Low: tasks that spin for 500us and submit themselves again, so the lane never runs dry
+ *      - 4 per worker are kept queued
+ * - High: one every 500us from another thread, each records the time from submit() to its start
+ * - Configurations
+ *      - one lane: the high tasks go into the low lane too, a plain FIFO pool
+ *      - strict, weighted 8:4:1
+ *      - strict with 1 reserved worker
+ * - Also the low lane's share: how many low tasks ran, and the longest any of them waited
+ * - Each one runs for 1s by default
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+std::uint64_t nanoseconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count();
+}
+
+void spin_for(std::chrono::microseconds duration)
+{
+    auto end = bench_clock::now() + duration;
+    while (bench_clock::now() < end) {
+    }
+}
+
+struct BenchResult {
+    LatencyHistogram high_latency;
+    LatencyHistogram low_latency;
+};
+
+struct LowTasks {
+    PriorityPool *pool;
+    std::atomic<bool> stop {false};
+    LatencyRecorder latency;
+
+    void submit()
+    {
+        auto queued_at = bench_clock::now();
+        pool->submit(Priority::low, [this, queued_at] {
+            latency.record(nanoseconds_since(queued_at));
+            spin_for(500us);
+            if (!stop.load(std::memory_order_relaxed)) {
+                submit();
+            }
+        });
+    }
+};
+
+BenchResult saturated_latency(unsigned workers, PriorityPoolOptions options, Priority request_lane,
+                              std::chrono::milliseconds duration)
+{
+    LatencyRecorder high_latency;
+    LowTasks low;
+    {
+        PriorityPool pool(workers, options);
+        low.pool = &pool;
+        for (unsigned i = 0; i < 4 * workers; ++i) {
+            low.submit();
+        }
+
+        auto end = bench_clock::now() + duration;
+        while (bench_clock::now() < end) {
+            auto queued_at = bench_clock::now();
+            pool.submit(request_lane, [&high_latency, queued_at] {
+                high_latency.record(nanoseconds_since(queued_at));
+                spin_for(20us);
+            });
+            std::this_thread::sleep_for(500us);
+        }
+        low.stop = true;
+    }
+    return BenchResult{high_latency.snapshot(), low.latency.snapshot()};
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(download_example);
+    thread4.join();
+
+    std::chrono::milliseconds duration(argc > 1 ? std::stoi(argv[1]) : 1000);
+    unsigned workers = std::max(2u, std::thread::hardware_concurrency());
+
+    PriorityPoolOptions strict;
+    PriorityPoolOptions weighted;
+    weighted.policy = DequeuePolicy::weighted;
+    PriorityPoolOptions reserved;
+    reserved.reserved_high = 1;
+
+    struct Config {
+        std::string label;
+        PriorityPoolOptions options;
+        Priority request_lane;
+    };
+    std::vector<Config> configs {
+            {"one lane", strict, Priority::low},
+            {"strict", strict, Priority::high},
+            {"weighted 8:4:1", weighted, Priority::high},
+            {"strict, 1 reserved", reserved, Priority::high},
+    };
+
+    std::cout << "\n" << workers << " workers, low lane saturated with 500us tasks, a high task every 500us" << std::endl;
+    LatencyHistogram::print_summary_header(std::cout);
+    std::vector<LatencyHistogram> low_latencies;
+    for (auto &config : configs) {
+        BenchResult result = saturated_latency(workers, config.options, config.request_lane, duration);
+        result.high_latency.print_summary(std::cout, "high, " + config.label);
+        low_latencies.push_back(result.low_latency);
+    }
+    for (std::size_t i = 0; i < configs.size(); ++i) {
+        low_latencies[i].print_summary(std::cout, "low, " + configs[i].label);
+    }
+
+    return 0;
+}
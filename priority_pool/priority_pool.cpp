@@ -0,0 +1,161 @@
+#include "priority_pool.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+#include "run_task.h"
+
+const char *priority_name(Priority priority)
+{
+    switch (priority) {
+        case Priority::high:
+            return "high";
+        case Priority::normal:
+            return "normal";
+        case Priority::low:
+            return "low";
+    }
+    return "unknown";
+}
+
+PriorityPool::PriorityPool(unsigned thread_count, PriorityPoolOptions pool_options) : options(pool_options)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    if (options.reserved_high >= thread_count) {
+        throw std::invalid_argument("PriorityPool: reserved_high must leave at least one general worker");
+    }
+    for (unsigned weight : options.weights) {
+        if (weight == 0) {
+            throw std::invalid_argument("PriorityPool: every lane needs a weight of at least 1");
+        }
+    }
+    credit = options.weights;
+
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&PriorityPool::worker_loop, this, i < options.reserved_high);
+    }
+}
+
+PriorityPool::~PriorityPool()
+{
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        stopping = true;
+    }
+    any_lane_cv.notify_all();
+    high_lane_cv.notify_all();
+    for (auto &thr : threads) {
+        thr.join();
+    }
+}
+
+void PriorityPool::submit(Priority priority, Task task)
+{
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    lanes[static_cast<std::size_t>(priority)].push_back(Item{std::move(task), clock::now()});
+
+    // A high task goes to a reserved worker if one is idle, anything else to a general worker
+    bool to_reserved = priority == Priority::high && high_lane_sleeping > 0;
+    bool to_general = !to_reserved && any_lane_sleeping > 0;
+    uniq_lck.unlock();
+    if (to_reserved) {
+        high_lane_cv.notify_one();
+    }
+    else if (to_general) {
+        any_lane_cv.notify_one();
+    }
+}
+
+// Called with mut held, returns -1 if there is nothing this worker may take
+int PriorityPool::pick_lane(bool high_only, clock::time_point now)
+{
+    if (high_only) {
+        return lanes[0].empty() ? -1 : 0;
+    }
+
+    // Whatever has waited too long goes first, the longest-waiting of those
+    if (options.max_wait.count() > 0) {
+        int oldest = -1;
+        for (std::size_t lane = 0; lane < priority_lane_count; ++lane) {
+            if (!lanes[lane].empty() && now - lanes[lane].front().queued_at > options.max_wait &&
+                (oldest < 0 || lanes[lane].front().queued_at < lanes[oldest].front().queued_at)) {
+                oldest = static_cast<int>(lane);
+            }
+        }
+        // The top non-empty lane would have been picked anyway, so only count the others
+        if (oldest >= 0) {
+            for (std::size_t lane = 0; lane < static_cast<std::size_t>(oldest); ++lane) {
+                if (!lanes[lane].empty()) {
+                    ++counters.aged;
+                    break;
+                }
+            }
+            return oldest;
+        }
+    }
+
+    if (options.policy == DequeuePolicy::strict) {
+        for (std::size_t lane = 0; lane < priority_lane_count; ++lane) {
+            if (!lanes[lane].empty()) {
+                return static_cast<int>(lane);
+            }
+        }
+        return -1;
+    }
+
+    // weighted: highest lane which still has credit, refill once every non-empty lane is out
+    for (int round = 0; round < 2; ++round) {
+        for (std::size_t lane = 0; lane < priority_lane_count; ++lane) {
+            if (!lanes[lane].empty() && credit[lane] > 0) {
+                --credit[lane];
+                return static_cast<int>(lane);
+            }
+        }
+        credit = options.weights;
+    }
+    return -1;
+}
+
+void PriorityPool::worker_loop(bool high_only)
+{
+    std::condition_variable &cv = high_only ? high_lane_cv : any_lane_cv;
+    int &sleeping = high_only ? high_lane_sleeping : any_lane_sleeping;
+
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    while (true) {
+        int lane = pick_lane(high_only, clock::now());
+        if (lane < 0) {
+            if (stopping) {
+                // Leave nothing behind: a reserved worker stops once high is empty,
+                // the general workers once every lane is
+                break;
+            }
+            ++sleeping;
+            cv.wait(uniq_lck);
+            --sleeping;
+            continue;
+        }
+
+        Task task = std::move(lanes[lane].front().task);
+        lanes[lane].pop_front();
+        ++counters.started[lane];
+        uniq_lck.unlock();
+        run_task(task, "PriorityPool");
+        task = nullptr;
+        uniq_lck.lock();
+    }
+}
+
+std::size_t PriorityPool::queued(Priority priority)
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    return lanes[static_cast<std::size_t>(priority)].size();
+}
+
+PriorityPoolStats PriorityPool::stats()
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    return counters;
+}
@@ -0,0 +1,106 @@
+#ifndef PRIORITY_POOL_PRIORITY_POOL_H
+#define PRIORITY_POOL_PRIORITY_POOL_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Priority Lanes
+ *
+ * - Short latency-critical tasks (answer a request) and long batch tasks (the 2s fetch loop) in one
+ *      FIFO queue: a request waits behind every batch task queued before it
+ * - So each priority gets its own queue, a "lane", and a worker picks which lane to take from
+ *
+ * - Dequeue policy
+ *      - strict: always the highest non-empty lane
+ *              - Lowest latency for high, but low can wait forever while high is busy
+ *      - weighted: lanes get turns in proportion to their weights, e.g. 8:4:1
+ *              - Credit per lane, spent one per task, refilled when every non-empty lane is out
+ *              - Low always gets some share, high still goes first most of the time
+ *
+ * - Starvation protection (aging)
+ *      - Any task which has waited longer than max_wait is taken next, whatever its lane
+ *      - Bounds the wait of low tasks under strict, and of every lane under weighted
+ *      - Keep it well above the length of a batch task, or the batch backlog jumps the queue too
+ *
+ * - Reserved workers
+ *      - A task cannot be interrupted: once every worker is in a batch task,
+ *              a high task waits for one of them to finish, whatever the policy
+ *      - reserved_high workers only ever take from the high lane, so one of them is usually free
+ *
+ * - One mutex for all the lanes: the tasks here are long enough that it is not the bottleneck
+ *      - For many tiny tasks see worker_pool
+ *
+ * - A task which throws is reported and skipped, see run_task.h in worker_pool
+ *      */
+
+enum class Priority {high, normal, low};
+constexpr std::size_t priority_lane_count = 3;
+
+const char *priority_name(Priority priority);
+
+enum class DequeuePolicy {strict, weighted};
+
+struct PriorityPoolOptions {
+    DequeuePolicy policy = DequeuePolicy::strict;
+    std::array<unsigned, priority_lane_count> weights {8, 4, 1};
+    std::chrono::microseconds max_wait {std::chrono::milliseconds(500)};  // 0 turns aging off
+    unsigned reserved_high = 0;
+};
+
+struct PriorityPoolStats {
+    std::array<std::uint64_t, priority_lane_count> started {};
+    std::uint64_t aged {0};     // taken out of turn because they waited longer than max_wait
+};
+
+class PriorityPool {
+public:
+    using Task = std::function<void()>;
+    using clock = std::chrono::steady_clock;
+
+private:
+    struct Item {
+        Task task;
+        clock::time_point queued_at;
+    };
+
+    PriorityPoolOptions options;
+    std::vector<std::thread> threads;
+
+    std::mutex mut;
+    std::array<std::deque<Item>, priority_lane_count> lanes;
+    std::array<unsigned, priority_lane_count> credit {};
+    std::condition_variable any_lane_cv;    // general workers sleep here
+    std::condition_variable high_lane_cv;   // reserved workers sleep here
+    int any_lane_sleeping = 0;
+    int high_lane_sleeping = 0;
+    bool stopping = false;
+    PriorityPoolStats counters;
+
+    void worker_loop(bool high_only);
+    int pick_lane(bool high_only, clock::time_point now);
+
+public:
+    // 0 threads means one per hardware thread
+    explicit PriorityPool(unsigned thread_count = 0, PriorityPoolOptions pool_options = PriorityPoolOptions());
+    ~PriorityPool();
+
+    PriorityPool(const PriorityPool &source) = delete;
+    PriorityPool &operator=(const PriorityPool &source) = delete;
+
+    void submit(Priority priority, Task task);
+
+    std::size_t queued(Priority priority);
+    PriorityPoolStats stats();
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+};
+
+#endif //PRIORITY_POOL_PRIORITY_POOL_H
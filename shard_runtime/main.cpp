@@ -0,0 +1,204 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <future>
+#include <vector>
+#include <unordered_map>
+#include <random>
+#include <cstdint>
+
+#include "shard_runtime.h"
+
+/*
+ * ThreadSafeVector from working_with_shared_data, without the mutex
+ * - The vector belongs to shard 0, and only shard 0 touches it
+ * - Other threads push and print by sending shard 0 a message
+ *      */
+
+void owned_vector_example()
+{
+    ShardRuntime runtime(2);
+    std::vector<int> vec;       // shard 0's
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&runtime, &vec, t] {
+            for (int i = 0; i < 3; ++i) {
+                runtime.post_to(0, [&vec, t, i] {vec.push_back(t * 10 + i);});
+            }
+        });
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+
+    // The mailbox from outside the runtime is FIFO, so this runs after all the pushes above
+    std::size_t size = runtime.submit_to(0, [&vec] {
+        std::cout << "Shard " << 0 << " owns:";
+        for (int value : vec) {
+            std::cout << " " << value;
+        }
+        std::cout << std::endl;
+        return vec.size();
+    }).get();
+    std::cout << "Size from the future: " << size << std::endl;
+}
+
+/*
+ * Key-value benchmark
+ * - 100000 keys, 90% get / 10% put, keys uniformly random
+ * - mutex: one std::unordered_map behind one std::mutex, every thread does its own operations
+ * - sharded: each shard owns the keys with key % shards == index, in a map of its own
+ *      - Each shard generates its share of the operations
+ *      - Its own keys: done in place, no lock, no message
+ *      - Other keys: a message to the owner, which replies with a message back
+ *              - Up to 256 requests in flight per shard, replies handled in run_pending()
+ * - Millions of operations per second, for 1, 2, 4... threads or shards
+ * - On a machine with fewer cores than shards, shards take turns on a core and each message
+ *      waits for the owner to be scheduled: the sharded model needs its cores
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+double mops(std::uint64_t ops, bench_clock::time_point start)
+{
+    return static_cast<double>(ops) / std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+double mutex_kv(unsigned threads, std::uint64_t ops, std::uint64_t keys)
+{
+    std::unordered_map<std::uint64_t, std::uint64_t> map;
+    std::mutex mut;
+    for (std::uint64_t k = 0; k < keys; ++k) {
+        map[k] = k;
+    }
+
+    auto start = bench_clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; ++t) {
+        workers.emplace_back([&map, &mut, t, threads, ops, keys] {
+            std::mt19937_64 rng(t);
+            std::uint64_t found {0};
+            for (std::uint64_t i = 0; i < ops / threads; ++i) {
+                std::uint64_t key = rng() % keys;
+                bool put = rng() % 10 == 0;
+                std::lock_guard<std::mutex> lck_guard(mut);
+                if (put) {
+                    map[key] = i;
+                }
+                else {
+                    found += map.find(key)->second;
+                }
+            }
+            volatile std::uint64_t sink = found;
+            (void)sink;
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    return mops(ops / threads * threads, start);
+}
+
+double sharded_kv(unsigned shard_count, std::uint64_t ops, std::uint64_t keys)
+{
+    ShardRuntime runtime(shard_count);
+    std::vector<std::unordered_map<std::uint64_t, std::uint64_t>> maps(shard_count);
+
+    // Each shard fills its own map
+    std::vector<std::future<void>> filled;
+    for (unsigned s = 0; s < shard_count; ++s) {
+        filled.push_back(runtime.submit_to(s, [&maps, s, shard_count, keys] {
+            for (std::uint64_t k = s; k < keys; k += shard_count) {
+                maps[s][k] = k;
+            }
+        }));
+    }
+    for (auto &f : filled) {
+        f.get();
+    }
+
+    auto start = bench_clock::now();
+    std::vector<std::future<void>> done;
+    for (unsigned s = 0; s < shard_count; ++s) {
+        done.push_back(runtime.submit_to(s, [&runtime, &maps, s, shard_count, ops, keys] {
+            std::mt19937_64 rng(s);
+            std::uint64_t found {0};
+            int in_flight {0};          // only ever touched on this shard
+            for (std::uint64_t i = 0; i < ops / shard_count; ++i) {
+                std::uint64_t key = rng() % keys;
+                bool put = rng() % 10 == 0;
+                unsigned owner = static_cast<unsigned>(key % shard_count);
+
+                if (owner == s) {
+                    if (put) {
+                        maps[s][key] = i;
+                    }
+                    else {
+                        found += maps[s].find(key)->second;
+                    }
+                }
+                else {
+                    while (in_flight >= 256) {
+                        if (!runtime.run_pending()) {
+                            std::this_thread::yield();
+                        }
+                    }
+                    ++in_flight;
+                    runtime.post_to(owner, [&runtime, &maps, &in_flight, owner, s, key, put, i] {
+                        std::uint64_t value {0};
+                        if (put) {
+                            maps[owner][key] = i;
+                        }
+                        else {
+                            value = maps[owner].find(key)->second;
+                        }
+                        runtime.post_to(s, [&in_flight, value] {
+                            --in_flight;
+                            volatile std::uint64_t sink = value;
+                            (void)sink;
+                        });
+                    });
+                }
+                // Serve the other shards' requests as we go
+                if (i % 16 == 0) {
+                    runtime.run_pending();
+                }
+            }
+            while (in_flight > 0) {
+                if (!runtime.run_pending()) {
+                    std::this_thread::yield();
+                }
+            }
+            volatile std::uint64_t sink = found;
+            (void)sink;
+        }));
+    }
+    for (auto &f : done) {
+        f.get();
+    }
+    return mops(ops / shard_count * shard_count, start);
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(owned_vector_example);
+    thread4.join();
+
+    std::uint64_t ops = argc > 1 ? std::stoull(argv[1]) : 1000000;
+    std::uint64_t keys = 100000;
+
+    std::cout << "\n" << std::left << std::setw(10) << "model" << std::right << std::setw(10) << "threads"
+              << std::setw(10) << "Mops/s" << std::endl;
+    for (unsigned n = 1; n <= std::max(4u, std::thread::hardware_concurrency()); n *= 2) {
+        std::cout << std::left << std::setw(10) << "mutex" << std::right << std::setw(10) << n << std::fixed
+                  << std::setprecision(2) << std::setw(10) << mutex_kv(n, ops, keys) << std::defaultfloat << std::endl;
+        std::cout << std::left << std::setw(10) << "sharded" << std::right << std::setw(10) << n << std::fixed
+                  << std::setprecision(2) << std::setw(10) << sharded_kv(n, ops, keys) << std::defaultfloat
+                  << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "shard_runtime.h"
+
+#include <algorithm>
+
+#include "run_task.h"
+
+// Which runtime, and which shard in it, the calling thread is
+static thread_local const ShardRuntime *this_thread_runtime = nullptr;
+static thread_local int this_thread_shard = -1;
+
+ShardRuntime::ShardRuntime(unsigned count, Placement placement, std::size_t mailbox_capacity)
+    : mailbox_capacity(mailbox_capacity)
+{
+    CpuTopology topo = read_cpu_topology();
+    if (count == 0) {
+        count = static_cast<unsigned>(std::max(1, topo.physical_cores()));
+    }
+    shard_count = count;
+
+    for (unsigned i = 0; i < shard_count; ++i) {
+        shards.push_back(std::make_unique<Shard>());
+    }
+    mailboxes.reset(new Mailbox[(shard_count + 1) * shard_count]);
+    threads = launch_threads(static_cast<int>(shard_count), placement, "shard",
+                             [this] (int index) {shard_loop(index);}, topo);
+}
+
+ShardRuntime::~ShardRuntime()
+{
+    stopping.store(true);
+    for (auto &shard : shards) {
+        std::lock_guard<std::mutex> lck_guard(shard->sleep_mut);
+        shard->sleeping->store(false);
+        shard->wake.notify_one();
+    }
+    for (auto &thr : threads) {
+        thr.join();
+    }
+}
+
+int ShardRuntime::current_shard() const
+{
+    return this_thread_runtime == this ? this_thread_shard : -1;
+}
+
+// Only the sender of the box, or an outside thread holding the shard's external_mut
+SpscQueue<ShardRuntime::Message> &ShardRuntime::outbox(std::size_t box)
+{
+    SpscQueue<Message> *queue = mailboxes[box].queue.load(std::memory_order_relaxed);
+    if (!queue) {
+        queue = new SpscQueue<Message>(mailbox_capacity);
+        mailboxes[box].queue.store(queue, std::memory_order_release);
+    }
+    return *queue;
+}
+
+// Only the receiver of the box
+SpscQueue<ShardRuntime::Message> *ShardRuntime::inbox(std::size_t box) const
+{
+    return mailboxes[box].queue.load(std::memory_order_acquire);
+}
+
+bool ShardRuntime::has_pending(int index) const
+{
+    for (unsigned from = 0; from <= shard_count; ++from) {
+        SpscQueue<Message> *box = inbox(from * shard_count + index);
+        if (box && !box->empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ShardRuntime::run_pending()
+{
+    int index = current_shard();
+    if (index < 0) {
+        return false;
+    }
+
+    bool ran = false;
+    Message message;
+    for (unsigned from = 0; from <= shard_count; ++from) {
+        SpscQueue<Message> *box = inbox(from * shard_count + index);
+        if (!box) {
+            continue;
+        }
+        // A batch at a time, so one busy sender cannot keep the others waiting
+        for (int i = 0; i < 64 && box->try_pop(message); ++i) {
+            run_task(message, "ShardRuntime");
+            message = nullptr;
+            ran = true;
+        }
+    }
+    return ran;
+}
+
+void ShardRuntime::notify(unsigned shard)
+{
+    // Pairs with the fence in shard_loop: either it sees our message, or we see it sleeping
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    Shard &target = *shards[shard];
+    if (target.sleeping->load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lck_guard(target.sleep_mut);
+        target.sleeping->store(false, std::memory_order_relaxed);
+        target.wake.notify_one();
+    }
+}
+
+void ShardRuntime::post_to(unsigned shard, Message fn)
+{
+    // While stopping, a full box is given up on: its receiver may have exited and never drain it
+    int self = current_shard();
+    if (self >= 0) {
+        SpscQueue<Message> &box = outbox(self * shard_count + shard);
+        while (!box.try_push(fn)) {
+            if (stopping.load()) {
+                return;
+            }
+            // Full: serve our own mailboxes meanwhile, the receiver may be waiting on us
+            if (!run_pending()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+    else {
+        std::lock_guard<std::mutex> lck_guard(shards[shard]->external_mut);
+        SpscQueue<Message> &box = outbox(shard_count * shard_count + shard);
+        while (!box.try_push(fn)) {
+            if (stopping.load()) {
+                return;
+            }
+            std::this_thread::yield();
+        }
+    }
+    notify(shard);
+}
+
+void ShardRuntime::shard_loop(int index)
+{
+    this_thread_runtime = this;
+    this_thread_shard = index;
+    Shard &shard = *shards[index];
+
+    int idle {0};
+    while (true) {
+        if (run_pending()) {
+            idle = 0;
+            continue;
+        }
+        if (stopping.load()) {
+            break;
+        }
+
+        // Poll a little before sleeping: a reply is often only microseconds away
+        if (++idle < 100) {
+            std::this_thread::yield();
+            continue;
+        }
+        idle = 0;
+
+        std::unique_lock<std::mutex> uniq_lck(shard.sleep_mut);
+        shard.sleeping->store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (has_pending(index) || stopping.load()) {
+            shard.sleeping->store(false, std::memory_order_relaxed);
+            continue;
+        }
+        shard.wake.wait(uniq_lck, [&shard] {return !shard.sleeping->load(std::memory_order_relaxed);});
+    }
+}
@@ -0,0 +1,119 @@
+#ifndef SHARD_RUNTIME_SHARD_RUNTIME_H
+#define SHARD_RUNTIME_SHARD_RUNTIME_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "cache_padded.h"
+#include "launcher.h"
+#include "spsc_queue.h"
+
+/*
+ * Thread-per-core Sharded Runtime
+ *
+ * - ThreadSafeVector and ThreadSafeQueue share one object between all threads behind a mutex
+ *      - Every access moves the lock's cache line, and the data's, to the accessing core
+ *      - Under load the threads mostly wait for each other
+ * - Here nothing mutable is shared
+ *      - One thread per core, a "shard", pinned (Placement::physical_cores)
+ *      - Each shard owns its part of the data, e.g. the keys with key % shard_count == index
+ *      - Only the owning shard ever touches it, so it needs no lock at all
+ *      - Other shards ask the owner with a message: a function to run on the owner's thread
+ *
+ * - Mailboxes
+ *      - One SpscQueue for every (sender, receiver) pair: each queue has exactly one producer
+ *              and one consumer, so no locks and no compare-exchange on the message path
+ *      - Threads from outside the runtime share one extra queue per shard, behind a mutex
+ *      - (shards + 1) * shards queues of mailbox_capacity std::function slots (32 bytes each)
+ *              - 64 shards talking to all the others with the default 1024: about 136MB
+ *              - So a queue is only allocated by its sender's first message, pairs that never
+ *                      talk cost one pointer
+ *      - A shard polls its incoming queues; after a while with nothing to do it sleeps,
+ *              and a sender wakes it (the sleeping/fence check of worker_pool)
+ *
+ * - submit_to(shard, fn) runs fn on that shard and returns a std::future of its result
+ *      - Inside a shard, do not block on the future: that shard stops serving its own mailboxes.
+ *              Post the reply back instead (post_to), and call run_pending() while waiting
+ * - post_to(shard, fn) is the same without a result
+ *      - A shard whose outgoing queue is full runs its own pending messages until there is room,
+ *              so two shards sending to each other cannot both block
+ *      - Once the runtime is stopping, a message which does not fit is dropped instead of waited for:
+ *              the receiver may already have exited
+ * - A message which throws is reported and skipped, see run_task.h in worker_pool
+ *      - A submit_to() message never throws: its exception goes to the future
+ *      */
+
+class ShardRuntime {
+public:
+    using Message = std::function<void()>;
+
+private:
+    struct Shard {
+        CachePadded<std::atomic<bool>> sleeping {false};
+        std::mutex sleep_mut;
+        std::condition_variable wake;
+        std::mutex external_mut;    // one outside thread at a time on the external queue
+    };
+
+    // Created by the sender on first use, the receiver treats nullptr as empty
+    struct Mailbox {
+        std::atomic<SpscQueue<Message> *> queue {nullptr};
+
+        ~Mailbox() { delete queue.load(); }
+    };
+
+    unsigned shard_count;
+    std::size_t mailbox_capacity;
+    std::vector<std::unique_ptr<Shard>> shards;
+    // mailboxes[from * shard_count + to], from == shard_count is "outside the runtime"
+    std::unique_ptr<Mailbox[]> mailboxes;
+    std::atomic<bool> stopping {false};
+    std::vector<std::thread> threads;
+
+    SpscQueue<Message> &outbox(std::size_t box);
+    SpscQueue<Message> *inbox(std::size_t box) const;
+    void shard_loop(int index);
+    bool has_pending(int index) const;
+    void notify(unsigned shard);
+
+public:
+    // 0 shards means one per physical core
+    explicit ShardRuntime(unsigned count = 0, Placement placement = Placement::physical_cores,
+                          std::size_t mailbox_capacity = 1024);
+    // Stops the shards, each runs the messages already in its mailboxes before it exits
+    // Only messages post_to() gave up on while stopping (their box was full) are dropped
+    ~ShardRuntime();
+
+    ShardRuntime(const ShardRuntime &source) = delete;
+    ShardRuntime &operator=(const ShardRuntime &source) = delete;
+
+    unsigned size() const { return shard_count; }
+
+    // Index of the calling shard in this runtime, -1 if the caller is not one of its shards
+    int current_shard() const;
+
+    void post_to(unsigned shard, Message fn);
+
+    template <typename Fn>
+    auto submit_to(unsigned shard, Fn fn) -> std::future<std::invoke_result_t<Fn>>
+    {
+        using Result = std::invoke_result_t<Fn>;
+        // packaged_task cannot be copied, std::function needs a copyable function
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::move(fn));
+        std::future<Result> result = task->get_future();
+        post_to(shard, [task] {(*task)();});
+        return result;
+    }
+
+    // From a shard: runs the messages waiting for it, returns false if there were none
+    bool run_pending();
+};
+
+#endif //SHARD_RUNTIME_SHARD_RUNTIME_H
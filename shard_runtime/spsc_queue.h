@@ -0,0 +1,90 @@
+#ifndef SHARD_RUNTIME_SPSC_QUEUE_H
+#define SHARD_RUNTIME_SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include "cache_padded.h"
+
+/*
+ * Single-producer single-consumer queue
+ *
+ * - One thread pushes, one other thread pops: no lock, no compare-exchange
+ *      - The producer only writes tail, the consumer only writes head
+ *      - A slot is published by the release store of tail, and freed by the release store of head
+ * - Fixed capacity (rounded up to a power of two), try_push() fails when it is full
+ * - head and tail are on cache lines of their own (CachePadded), so the two threads only share
+ *      a line when one of them actually looks at the other's index
+ *      - Each side also keeps its last look at the other's index, and only reads it again
+ *              when the queue seems full (producer) or empty (consumer)
+ *      */
+
+template <typename T>
+class SpscQueue {
+private:
+    std::vector<T> slots;
+    std::size_t mask;
+
+    CachePadded<std::atomic<std::size_t>> head {0};     // next slot to pop, written by the consumer
+    CachePadded<std::atomic<std::size_t>> tail {0};     // next slot to push, written by the producer
+    CachePadded<std::size_t> head_seen {0};             // the producer's copy of head
+    CachePadded<std::size_t> tail_seen {0};             // the consumer's copy of tail
+
+    static std::size_t round_up(std::size_t n)
+    {
+        std::size_t size {1};
+        while (size < n) {
+            size *= 2;
+        }
+        return size;
+    }
+
+public:
+    explicit SpscQueue(std::size_t capacity) : slots(round_up(capacity)), mask(slots.size() - 1) {}
+
+    SpscQueue(const SpscQueue &source) = delete;
+    SpscQueue &operator=(const SpscQueue &source) = delete;
+
+    // Producer only. value is left alone if the queue is full
+    bool try_push(T &value)
+    {
+        std::size_t t = tail->load(std::memory_order_relaxed);
+        if (t - *head_seen == slots.size()) {
+            *head_seen = head->load(std::memory_order_acquire);
+            if (t - *head_seen == slots.size()) {
+                return false;
+            }
+        }
+        slots[t & mask] = std::move(value);
+        tail->store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool try_pop(T &out)
+    {
+        std::size_t h = head->load(std::memory_order_relaxed);
+        if (h == *tail_seen) {
+            *tail_seen = tail->load(std::memory_order_acquire);
+            if (h == *tail_seen) {
+                return false;
+            }
+        }
+        out = std::move(slots[h & mask]);
+        slots[h & mask] = T();
+        head->store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer only
+    bool empty() const
+    {
+        return head->load(std::memory_order_relaxed) == tail->load(std::memory_order_acquire);
+    }
+
+    std::size_t capacity() const { return slots.size(); }
+};
+
+#endif //SHARD_RUNTIME_SPSC_QUEUE_H
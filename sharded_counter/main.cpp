@@ -0,0 +1,118 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "sharded_counter.h"
+
+using namespace std::literals;
+
+/*
+ * ThreadSafeVector and func() from working_with_shared_data
+ * - Now every push is also counted in a ShardedCounter
+ *      */
+class ThreadSafeVector{
+private:
+    std::mutex m;
+    std::vector<int> vec;
+
+public:
+
+    void push_back(const int &val) {
+        std::lock_guard<std::mutex> lock(m);
+        vec.push_back(val);
+    }
+
+    std::size_t size() {
+        std::lock_guard<std::mutex> lock(m);
+        return vec.size();
+    }
+};
+
+ShardedCounter items_processed;
+
+void func(ThreadSafeVector &vec) {
+    for (int i{0}; i < 5; ++i) {
+        vec.push_back(i);
+        items_processed.increment();
+        std::this_thread::sleep_for(10ms);
+    }
+}
+
+/*
+ * Benchmark: N threads each count "increments" items
+ * - One std::atomic<uint64_t> shared by everyone
+ * - ShardedCounter, a shard per thread
+ * - ShardedCounter, a shard per CPU
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename Count, typename Total>
+double increments_per_second(int threads, std::uint64_t increments, Count count, Total total)
+{
+    std::vector<std::thread> workers;
+    auto start = bench_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([increments, &count] {
+            for (std::uint64_t i = 0; i < increments; ++i) {
+                count();
+            }
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    if (total() != threads * increments) {
+        std::cout << "Lost increments: " << total() << " != " << threads * increments << std::endl;
+    }
+    return threads * increments / seconds / 1e6;
+}
+
+void benchmark(std::uint64_t increments)
+{
+    std::cout << "\nMillion increments per second" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(14) << "atomic" << std::setw(18) << "shard/thread"
+              << std::setw(14) << "shard/cpu" << std::endl;
+
+    for (int threads : {1, 2, 4, 8, 16, 32, 64}) {
+        std::atomic<std::uint64_t> shared {0};
+        ShardedCounter by_thread(ShardBy::thread, threads);
+        ShardedCounter by_cpu(ShardBy::cpu);
+
+        std::cout << std::setw(8) << threads
+                  << std::setw(14) << increments_per_second(threads, increments,
+                                                            [&] {shared.fetch_add(1, std::memory_order_relaxed);},
+                                                            [&] {return shared.load();})
+                  << std::setw(18) << increments_per_second(threads, increments,
+                                                            [&] {by_thread.increment();},
+                                                            [&] {return by_thread.read();})
+                  << std::setw(14) << increments_per_second(threads, increments,
+                                                            [&] {by_cpu.increment();},
+                                                            [&] {return by_cpu.read();}) << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    ThreadSafeVector my_vec;
+
+    std::thread vp1(func, std::ref(my_vec));
+    std::thread vp2(func, std::ref(my_vec));
+    std::thread vp3(func, std::ref(my_vec));
+
+    vp1.join(); vp2.join(); vp3.join();
+    std::cout << "Items processed: " << items_processed.read() << " (vector size " << my_vec.size()
+              << ", " << items_processed.shard_count() << " shards)" << std::endl;
+
+    std::uint64_t increments = argc > 1 ? std::stoull(argv[1]) : 500'000;
+    benchmark(increments);
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include "sharded_counter.h"
+
+#include <thread>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+std::size_t this_thread_shard_hint()
+{
+    static std::atomic<std::size_t> next {0};
+    thread_local std::size_t hint = next.fetch_add(1, std::memory_order_relaxed);
+    return hint;
+}
+
+std::size_t this_thread_cpu()
+{
+#if defined(__linux__)
+    int cpu = sched_getcpu();
+    return cpu < 0 ? 0 : static_cast<std::size_t>(cpu);
+#else
+    return 0;
+#endif
+}
+
+ShardedCounter::ShardedCounter(ShardBy shard_by, std::size_t shard_count) : shard_by(shard_by)
+{
+    if (shard_count == 0) {
+        shard_count = std::thread::hardware_concurrency();
+    }
+    std::size_t rounded {1};
+    while (rounded < shard_count) {
+        rounded *= 2;
+    }
+    shards.reset(new CachePadded<std::atomic<std::uint64_t>>[rounded]);
+    mask = rounded - 1;
+}
+
+std::uint64_t ShardedCounter::read() const
+{
+    std::uint64_t total {0};
+    for (std::size_t i = 0; i <= mask; ++i) {
+        total += shards[i]->load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ShardedCounter::reset()
+{
+    for (std::size_t i = 0; i <= mask; ++i) {
+        shards[i]->store(0, std::memory_order_relaxed);
+    }
+}
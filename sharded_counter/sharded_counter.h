@@ -0,0 +1,87 @@
+#ifndef SHARDED_COUNTER_SHARDED_COUNTER_H
+#define SHARDED_COUNTER_SHARDED_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "cache_padded.h"
+
+/*
+ * Sharded Counter
+ *
+ * - Counting items processed by many threads with one std::atomic<uint64_t>
+ *      - Every fetch_add needs the cache line in exclusive mode
+ *      - With N threads the line moves between cores on nearly every increment
+ *      - The counter becomes the slowest part of the loop
+ *
+ * - Instead: many counters ("shards"), each on its own cache line (CachePadded)
+ *      - A thread always increments the same shard, so the line stays in its cache
+ *      - read() adds up all the shards
+ *
+ * - Picking a shard
+ *      - ShardBy::thread: each thread gets the next shard number, round-robin, the first time it counts
+ *              - Free after that, but threads beyond the shard count share shards
+ *      - ShardBy::cpu: the shard of the CPU the thread is running on (sched_getcpu)
+ *              - Threads on the same CPU never run at the same time, so they don't fight over the line
+ *              - Costs a few nanoseconds per increment, and a thread can migrate between two calls
+ *      - Either way two threads can end up on one shard, so increments are still atomic
+ *              - fetch_add with memory_order_relaxed: we only need the total, not any ordering
+ *
+ * - read() is not a snapshot
+ *      - Increments made while it runs may or may not be included
+ *      - Once all writers have stopped (e.g. after join), it is exact
+ *      */
+
+enum class ShardBy {
+    thread,
+    cpu
+};
+
+// Round-robin number given to each thread the first time it touches any ShardedCounter
+std::size_t this_thread_shard_hint();
+
+// CPU the calling thread is running on, 0 if the platform can't tell
+std::size_t this_thread_cpu();
+
+class ShardedCounter {
+private:
+    std::unique_ptr<CachePadded<std::atomic<std::uint64_t>>[]> shards;
+    std::size_t mask;
+    ShardBy shard_by;
+
+    std::atomic<std::uint64_t> &my_shard()
+    {
+        std::size_t index = shard_by == ShardBy::thread ? this_thread_shard_hint() : this_thread_cpu();
+        return *shards[index & mask];
+    }
+
+public:
+    // 0 shards means one per hardware thread
+    // The count is rounded up to a power of 2
+    explicit ShardedCounter(ShardBy shard_by = ShardBy::thread, std::size_t shard_count = 0);
+
+    ShardedCounter(const ShardedCounter &source) = delete;
+    ShardedCounter &operator=(const ShardedCounter &source) = delete;
+
+    void add(std::uint64_t n)
+    {
+        my_shard().fetch_add(n, std::memory_order_relaxed);
+    }
+
+    void increment()
+    {
+        add(1);
+    }
+
+    // Sum of all shards
+    std::uint64_t read() const;
+
+    // Only exact if no thread is counting at the same time
+    void reset();
+
+    std::size_t shard_count() const { return mask + 1; }
+};
+
+#endif //SHARDED_COUNTER_SHARDED_COUNTER_H
@@ -0,0 +1,136 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <random>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cmath>
+#include <algorithm>
+
+#include "rng.h"
+#include "uniform_fill.h"
+
+/*
+ * Checks
+ * - Every kernel the CPU supports must produce the same numbers as the scalar loop
+ * - Splitting one fill into several smaller fills must not change the numbers
+ *      - The counter carries on from where the last fill stopped
+ * - The numbers should look uniform: mean about 0.5, nothing outside [lo, hi)
+ *      */
+
+bool check_kernels()
+{
+    const std::size_t n = 1003; // not a multiple of the vector width, so the tails get used
+    std::vector<double> expected(n);
+    UniformStream reference {42};
+    fill_uniform_with(FillIsa::scalar, expected.data(), n, -1.0, 3.0, reference);
+
+    bool ok = true;
+    for (FillIsa isa : {FillIsa::avx2, FillIsa::avx512}) {
+        if (!fill_isa_supported(isa)) {
+            std::cout << fill_isa_name(isa) << ": not supported on this CPU" << std::endl;
+            continue;
+        }
+
+        std::vector<double> got(n);
+        UniformStream stream {42};
+        fill_uniform_with(isa, got.data(), 500, -1.0, 3.0, stream);
+        fill_uniform_with(isa, got.data() + 500, n - 500, -1.0, 3.0, stream);
+
+        double max_diff {0};
+        for (std::size_t i = 0; i < n; ++i) {
+            max_diff = std::max(max_diff, std::abs(got[i] - expected[i]));
+        }
+        bool same = max_diff < 1e-15;
+        ok = ok && same;
+        std::cout << fill_isa_name(isa) << ": " << (same ? "matches" : "DIFFERS FROM") << " scalar (max difference "
+                  << max_diff << ")" << std::endl;
+    }
+
+    std::vector<double> sample(1 << 20);
+    fill_uniform(sample, 0.0, 1.0);
+    double sum {0};
+    for (double d : sample) {
+        ok = ok && d >= 0.0 && d < 1.0;
+        sum += d;
+    }
+    std::cout << "Mean of " << sample.size() << " samples: " << sum / sample.size() << std::endl;
+    return ok;
+}
+
+/*
+ * Throughput benchmark
+ * - Fill the same buffer over and over, report GB/s of doubles written
+ * - Small buffer: stays in L1 cache, measures the generator
+ * - Large buffer: bigger than the caches, measures the generator plus memory bandwidth
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename Fill>
+double gigabytes_per_second(std::vector<double> &buffer, std::size_t total, Fill fill)
+{
+    std::size_t passes = std::max<std::size_t>(1, total / buffer.size());
+    fill(buffer); // warm up, fault the pages in
+
+    auto start = bench_clock::now();
+    for (std::size_t p = 0; p < passes; ++p) {
+        fill(buffer);
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+
+    volatile double keep = buffer[buffer.size() / 2];
+    (void)keep;
+    return passes * buffer.size() * sizeof(double) / seconds / 1e9;
+}
+
+void benchmark(std::size_t total)
+{
+    for (std::size_t size : {std::size_t{4096}, std::size_t{1} << 23}) {
+        std::vector<double> buffer(size);
+        std::cout << "\nBuffer of " << size << " doubles (" << size * sizeof(double) / 1024 << " KB), GB/s" << std::endl;
+
+        std::cout << "  " << std::left << std::setw(34) << "mt19937 + uniform_real" << std::right
+                  << gigabytes_per_second(buffer, total, [] (std::vector<double> &out) {
+                         thread_local std::mt19937 mt;
+                         std::uniform_real_distribution<double> dist(0, 1);
+                         for (double &d : out) {
+                             d = dist(mt);
+                         }
+                     }) << std::endl;
+
+        std::cout << "  " << std::left << std::setw(34) << "xoshiro256** + to_unit_double" << std::right
+                  << gigabytes_per_second(buffer, total, [] (std::vector<double> &out) {
+                         Xoshiro256StarStar &rng = thread_rng();
+                         for (double &d : out) {
+                             d = to_unit_double(rng());
+                         }
+                     }) << std::endl;
+
+        for (FillIsa isa : {FillIsa::scalar, FillIsa::avx2, FillIsa::avx512}) {
+            if (!fill_isa_supported(isa)) {
+                continue;
+            }
+            UniformStream stream {7};
+            std::cout << "  " << std::left << std::setw(34) << ("fill_uniform_with(" + std::string(fill_isa_name(isa)) + ")")
+                      << std::right
+                      << gigabytes_per_second(buffer, total, [isa, &stream] (std::vector<double> &out) {
+                             fill_uniform_with(isa, out.data(), out.size(), 0.0, 1.0, stream);
+                         }) << std::endl;
+        }
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::cout << "Best kernel on this CPU: " << fill_isa_name(best_fill_isa()) << std::endl;
+    if (!check_kernels()) {
+        std::cout << "Kernel check failed" << std::endl;
+        return 1;
+    }
+
+    std::size_t total = argc > 1 ? std::stoull(argv[1]) : std::size_t{1} << 25;
+    benchmark(total);
+
+    return 0;
+}
@@ -0,0 +1,216 @@
+#include "uniform_fill.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "rng.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define UNIFORM_FILL_X86 1
+#include <immintrin.h>
+#endif
+
+// SplitMix64 constants, see splitmix64() in rng.h
+static constexpr std::uint64_t golden = 0x9e3779b97f4a7c15ULL;
+static constexpr std::uint64_t mix1 = 0xbf58476d1ce4e5b9ULL;
+static constexpr std::uint64_t mix2 = 0x94d049bb133111ebULL;
+
+// Bit pattern of 1.0
+static constexpr std::uint64_t one_bits = 0x3FF0000000000000ULL;
+
+// Number "counter" of the stream "key"
+static inline std::uint64_t hash_counter(std::uint64_t key, std::uint64_t counter)
+{
+    std::uint64_t z = key + golden * (counter + 1);
+    z = (z ^ (z >> 30)) * mix1;
+    z = (z ^ (z >> 27)) * mix2;
+    return z ^ (z >> 31);
+}
+
+static inline double bits_to_unit(std::uint64_t z)
+{
+    std::uint64_t bits = (z >> 12) | one_bits;
+    double d;
+    std::memcpy(&d, &bits, sizeof d);
+    return d - 1.0;
+}
+
+// "top" is the largest double below hi: lo + u * scale can round up to hi itself, which is
+// outside [lo, hi), and is clamped back down
+static void fill_scalar(double *out, std::size_t n, double lo, double scale, double top,
+                        std::uint64_t key, std::uint64_t counter)
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        out[i] = std::min(lo + bits_to_unit(hash_counter(key, counter + i)) * scale, top);
+    }
+}
+
+#ifdef UNIFORM_FILL_X86
+
+// AVX2 has no 64-bit multiply, build it from three 32 x 32 -> 64 bit multiplies
+// (the high x high product only affects bits we throw away)
+__attribute__((target("avx2")))
+static inline __m256i mullo64_avx2(__m256i a, __m256i b)
+{
+    __m256i lo_lo = _mm256_mul_epu32(a, b);
+    __m256i hi_lo = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b);
+    __m256i lo_hi = _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32));
+    __m256i cross = _mm256_slli_epi64(_mm256_add_epi64(hi_lo, lo_hi), 32);
+    return _mm256_add_epi64(lo_lo, cross);
+}
+
+__attribute__((target("avx2")))
+static void fill_avx2(double *out, std::size_t n, double lo, double scale, double top,
+                      std::uint64_t key, std::uint64_t counter)
+{
+    // Lane j holds the un-hashed value of counter + i + j
+    __m256i state = _mm256_set_epi64x(static_cast<long long>(key + golden * (counter + 4)),
+                                      static_cast<long long>(key + golden * (counter + 3)),
+                                      static_cast<long long>(key + golden * (counter + 2)),
+                                      static_cast<long long>(key + golden * (counter + 1)));
+    const __m256i step = _mm256_set1_epi64x(static_cast<long long>(golden * 4));
+    const __m256i m1 = _mm256_set1_epi64x(static_cast<long long>(mix1));
+    const __m256i m2 = _mm256_set1_epi64x(static_cast<long long>(mix2));
+    const __m256i one = _mm256_set1_epi64x(static_cast<long long>(one_bits));
+    const __m256d v_one = _mm256_set1_pd(1.0);
+    const __m256d v_lo = _mm256_set1_pd(lo);
+    const __m256d v_scale = _mm256_set1_pd(scale);
+    const __m256d v_top = _mm256_set1_pd(top);
+
+    std::size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i z = state;
+        z = mullo64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 30)), m1);
+        z = mullo64_avx2(_mm256_xor_si256(z, _mm256_srli_epi64(z, 27)), m2);
+        z = _mm256_xor_si256(z, _mm256_srli_epi64(z, 31));
+
+        __m256d u = _mm256_sub_pd(_mm256_castsi256_pd(_mm256_or_si256(_mm256_srli_epi64(z, 12), one)), v_one);
+        _mm256_storeu_pd(out + i, _mm256_min_pd(_mm256_add_pd(v_lo, _mm256_mul_pd(u, v_scale)), v_top));
+
+        state = _mm256_add_epi64(state, step);
+    }
+    fill_scalar(out + i, n - i, lo, scale, top, key, counter + i);
+}
+
+// _mm512_srli_epi64 and _mm512_min_pd pass an undefined vector as the merge source of their
+// (all-ones) mask, and GCC 12 warns about that with -Wmaybe-uninitialized
+// The zero-masking forms with every lane selected compile to the same unmasked instructions
+template <int shift>
+__attribute__((target("avx512f")))
+static inline __m512i srli64_avx512(__m512i a)
+{
+    return _mm512_maskz_srli_epi64(0xFF, a, shift);
+}
+
+__attribute__((target("avx512f")))
+static inline __m512d min_avx512(__m512d a, __m512d b)
+{
+    return _mm512_maskz_min_pd(0xFF, a, b);
+}
+
+__attribute__((target("avx512f,avx512dq")))
+static void fill_avx512(double *out, std::size_t n, double lo, double scale, double top,
+                        std::uint64_t key, std::uint64_t counter)
+{
+    __m512i state = _mm512_set_epi64(static_cast<long long>(key + golden * (counter + 8)),
+                                     static_cast<long long>(key + golden * (counter + 7)),
+                                     static_cast<long long>(key + golden * (counter + 6)),
+                                     static_cast<long long>(key + golden * (counter + 5)),
+                                     static_cast<long long>(key + golden * (counter + 4)),
+                                     static_cast<long long>(key + golden * (counter + 3)),
+                                     static_cast<long long>(key + golden * (counter + 2)),
+                                     static_cast<long long>(key + golden * (counter + 1)));
+    const __m512i step = _mm512_set1_epi64(static_cast<long long>(golden * 8));
+    const __m512i m1 = _mm512_set1_epi64(static_cast<long long>(mix1));
+    const __m512i m2 = _mm512_set1_epi64(static_cast<long long>(mix2));
+    const __m512i one = _mm512_set1_epi64(static_cast<long long>(one_bits));
+    const __m512d v_one = _mm512_set1_pd(1.0);
+    const __m512d v_lo = _mm512_set1_pd(lo);
+    const __m512d v_scale = _mm512_set1_pd(scale);
+    const __m512d v_top = _mm512_set1_pd(top);
+
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m512i z = state;
+        z = _mm512_mullo_epi64(_mm512_xor_si512(z, srli64_avx512<30>(z)), m1);
+        z = _mm512_mullo_epi64(_mm512_xor_si512(z, srli64_avx512<27>(z)), m2);
+        z = _mm512_xor_si512(z, srli64_avx512<31>(z));
+
+        __m512d u = _mm512_sub_pd(_mm512_castsi512_pd(_mm512_or_si512(srli64_avx512<12>(z), one)), v_one);
+        _mm512_storeu_pd(out + i, min_avx512(_mm512_add_pd(v_lo, _mm512_mul_pd(u, v_scale)), v_top));
+
+        state = _mm512_add_epi64(state, step);
+    }
+    fill_scalar(out + i, n - i, lo, scale, top, key, counter + i);
+}
+
+#endif // UNIFORM_FILL_X86
+
+const char *fill_isa_name(FillIsa isa)
+{
+    switch (isa) {
+        case FillIsa::avx512: return "avx512";
+        case FillIsa::avx2: return "avx2";
+        default: return "scalar";
+    }
+}
+
+bool fill_isa_supported(FillIsa isa)
+{
+#ifdef UNIFORM_FILL_X86
+    switch (isa) {
+        case FillIsa::avx512: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq");
+        case FillIsa::avx2: return __builtin_cpu_supports("avx2");
+        default: return true;
+    }
+#else
+    return isa == FillIsa::scalar;
+#endif
+}
+
+FillIsa best_fill_isa()
+{
+    // Meyers singleton: asked once, thread-safe
+    static const FillIsa best = fill_isa_supported(FillIsa::avx512) ? FillIsa::avx512
+                              : fill_isa_supported(FillIsa::avx2) ? FillIsa::avx2
+                              : FillIsa::scalar;
+    return best;
+}
+
+// The caller has already checked that the CPU supports "isa"
+static void run_kernel(FillIsa isa, double *out, std::size_t n, double lo, double hi, UniformStream &stream)
+{
+    const double scale = hi - lo;
+    const double top = std::nextafter(hi, lo);
+    const std::uint64_t counter = stream.counter;
+    stream.counter += n;
+
+#ifdef UNIFORM_FILL_X86
+    if (isa == FillIsa::avx512) {
+        fill_avx512(out, n, lo, scale, top, stream.key, counter);
+        return;
+    }
+    if (isa == FillIsa::avx2) {
+        fill_avx2(out, n, lo, scale, top, stream.key, counter);
+        return;
+    }
+#endif
+    fill_scalar(out, n, lo, scale, top, stream.key, counter);
+}
+
+void fill_uniform_with(FillIsa isa, double *out, std::size_t n, double lo, double hi, UniformStream &stream)
+{
+    run_kernel(fill_isa_supported(isa) ? isa : FillIsa::scalar, out, n, lo, hi, stream);
+}
+
+void fill_uniform(double *out, std::size_t n, double lo, double hi, UniformStream &stream)
+{
+    run_kernel(best_fill_isa(), out, n, lo, hi, stream);
+}
+
+void fill_uniform(double *out, std::size_t n, double lo, double hi)
+{
+    thread_local UniformStream stream {thread_rng()()};
+    fill_uniform(out, n, lo, hi, stream);
+}
@@ -0,0 +1,72 @@
+#ifndef SIMD_UNIFORM_FILL_UNIFORM_FILL_H
+#define SIMD_UNIFORM_FILL_UNIFORM_FILL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Filling a Buffer with Uniform Doubles
+ *
+ * - func() in local_thread_variables draws one double at a time
+ *      std::uniform_real_distribution<double> dist(0, 1);
+ *      dist(mt);
+ * - Each call updates the engine state, which depends on the previous call
+ *      - The CPU cannot work on several numbers at once
+ *
+ * - Counter-based generator
+ *      - Number i of a stream is a hash of (key, counter + i)
+ *      - No state carried from one number to the next
+ *      - 4 (AVX2) or 8 (AVX-512) lanes hash 4 or 8 counters at the same time
+ *      - The hash is the SplitMix64 finalizer: shifts, xors and two 64-bit multiplies
+ *
+ * - Bits to double without a division or an int-to-float conversion
+ *      - Keep the top 52 bits as the mantissa
+ *      - OR in the exponent of 1.0 (0x3FF0000000000000)
+ *      - The bit pattern is now a double in [1, 2), subtract 1 to get [0, 1)
+ *
+ * - Runtime dispatch
+ *      - The kernels are compiled for AVX2 and AVX-512 with target attributes
+ *      - On first use we ask the CPU what it supports and pick the widest kernel
+ *      - Older CPUs (and non-x86 builds) use the scalar loop
+ *      - Every kernel produces the same stream of numbers
+ *              - up to the rounding of the final lo + u * (hi - lo)
+ *      - That rounding can land exactly on hi, so the result is clamped to the largest double below it
+ *      */
+
+// The state of one stream: which key, and how far along it we are
+struct UniformStream {
+    std::uint64_t key;
+    std::uint64_t counter = 0;
+};
+
+enum class FillIsa { scalar, avx2, avx512 };
+
+const char *fill_isa_name(FillIsa isa);
+bool fill_isa_supported(FillIsa isa);
+
+// The widest kernel this CPU can run
+FillIsa best_fill_isa();
+
+// Fill out[0, n) with doubles in [lo, hi) using the best kernel, and advance the stream by n
+// lo must be less than hi
+void fill_uniform(double *out, std::size_t n, double lo, double hi, UniformStream &stream);
+
+// Same again, forcing a particular kernel (for benchmarks and checks)
+void fill_uniform_with(FillIsa isa, double *out, std::size_t n, double lo, double hi, UniformStream &stream);
+
+// Use the calling thread's own stream, keyed from thread_rng() in per_thread_rng
+void fill_uniform(double *out, std::size_t n, double lo, double hi);
+
+// We are on C++17, so there is no std::span, these cover the common case
+inline void fill_uniform(std::vector<double> &out, double lo, double hi, UniformStream &stream)
+{
+    fill_uniform(out.data(), out.size(), lo, hi, stream);
+}
+
+inline void fill_uniform(std::vector<double> &out, double lo, double hi)
+{
+    fill_uniform(out.data(), out.size(), lo, hi);
+}
+
+#endif //SIMD_UNIFORM_FILL_UNIFORM_FILL_H
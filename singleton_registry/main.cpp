@@ -0,0 +1,168 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <stdexcept>
+
+#include "registry.h"
+
+using namespace std::literals;
+
+std::mutex print_mut;
+
+void print(const std::string &message)
+{
+    std::lock_guard<std::mutex> print_lock(print_mut);
+    std::cout << message << std::endl;
+}
+
+// A small service: config -> logger -> (database, cache) -> api
+struct Config {
+    std::string db_host = "db.example.com";
+    Config() { print("  Config built"); }
+    ~Config() { print("  Config destroyed"); }
+};
+
+struct Logger {
+    Config &config;
+    explicit Logger(Config &config) : config(config) { print("  Logger built"); }
+    ~Logger() { print("  Logger destroyed"); }
+};
+
+struct Database {
+    Logger &log;
+    std::string host;
+    Database(Logger &log, const Config &config) : log(log), host(config.db_host)
+    {
+        std::this_thread::sleep_for(50ms);
+        print("  Database connected to " + host);
+    }
+    ~Database() { print("  Database disconnected"); }
+};
+
+struct Cache {
+    Logger &log;
+    explicit Cache(Logger &log) : log(log)
+    {
+        std::this_thread::sleep_for(50ms);
+        print("  Cache warmed");
+    }
+    ~Cache() { print("  Cache flushed"); }
+};
+
+struct Api {
+    Database &db;
+    Cache &cache;
+    Api(Database &db, Cache &cache) : db(db), cache(cache) { print("  Api listening"); }
+    ~Api() { print("  Api stopped"); }
+};
+
+void demo()
+{
+    SingletonRegistry registry;
+    registry.add<Config>("config", {}, [] (SingletonRegistry &) {
+        return std::make_unique<Config>();
+    });
+    registry.add<Logger>("logger", {"config"}, [] (SingletonRegistry &r) {
+        return std::make_unique<Logger>(r.get<Config>("config"));
+    });
+    registry.add<Database>("database", {"logger", "config"}, [] (SingletonRegistry &r) {
+        return std::make_unique<Database>(r.get<Logger>("logger"), r.get<Config>("config"));
+    });
+    registry.add<Cache>("cache", {"logger"}, [] (SingletonRegistry &r) {
+        return std::make_unique<Cache>(r.get<Logger>("logger"));
+    });
+    registry.add<Api>("api", {"database", "cache"}, [] (SingletonRegistry &r) {
+        return std::make_unique<Api>(r.get<Database>("database"), r.get<Cache>("cache"));
+    });
+
+    print("Starting (database and cache are built at the same time)");
+    registry.start(4);
+    print("Shutting down");
+    registry.shutdown(4);
+
+    // A cycle is rejected before anything is built
+    SingletonRegistry broken;
+    broken.add<int>("a", {"b"}, [] (SingletonRegistry &) {return std::make_unique<int>(1);});
+    broken.add<int>("b", {"a"}, [] (SingletonRegistry &) {return std::make_unique<int>(2);});
+    try {
+        broken.start();
+    }
+    catch (const std::exception &e) {
+        print(std::string("start() failed: ") + e.what());
+    }
+}
+
+/*
+ * Cold start benchmark
+ * - 40 components in layers, like a real service
+ *      - 1 config, 1 logger, 4 metrics exporters, 8 connection pools, 16 caches, 8 handlers, 1 server, 1 health check
+ *      - Each layer depends on a couple of components in the layer below
+ * - Every constructor takes 20ms (network round trips, file loading)
+ * - Every destructor takes 5ms (flushing, closing)
+ * - Build with 1 thread (the old way, one after another) and with more threads
+ *      */
+
+struct Component {
+    explicit Component(std::chrono::milliseconds cost) { std::this_thread::sleep_for(cost); }
+    ~Component() { std::this_thread::sleep_for(5ms); }
+};
+
+void fill_service(SingletonRegistry &registry)
+{
+    const std::vector<std::pair<std::string, int>> layers {
+        {"config", 1}, {"logger", 1}, {"metrics", 4}, {"pool", 8}, {"cache", 16}, {"handler", 8}, {"server", 1}, {"health", 1}
+    };
+
+    std::vector<std::string> below;
+    for (const auto &layer : layers) {
+        std::vector<std::string> names;
+        for (int i = 0; i < layer.second; ++i) {
+            std::string name = layer.first + std::to_string(i);
+            std::vector<std::string> deps;
+            if (!below.empty()) {
+                // Two dependencies in the layer below
+                deps.push_back(below[i % below.size()]);
+                deps.push_back(below[(i + 1) % below.size()]);
+                if (deps[0] == deps[1]) {
+                    deps.pop_back();
+                }
+            }
+            registry.add<Component>(name, deps, [] (SingletonRegistry &) {
+                return std::make_unique<Component>(20ms);
+            });
+            names.push_back(name);
+        }
+        below = names;
+    }
+}
+
+using bench_clock = std::chrono::steady_clock;
+
+void benchmark()
+{
+    std::cout << "\nCold start of 40 components" << std::endl;
+    for (unsigned threads : {1u, 2u, 4u, 8u, 16u}) {
+        SingletonRegistry registry;
+        fill_service(registry);
+
+        auto before = bench_clock::now();
+        registry.start(threads);
+        auto started = bench_clock::now();
+        registry.shutdown(threads);
+        auto stopped = bench_clock::now();
+
+        std::cout << "  " << threads << " thread(s): start "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(started - before).count() << " ms, shutdown "
+                  << std::chrono::duration_cast<std::chrono::milliseconds>(stopped - started).count() << " ms" << std::endl;
+    }
+}
+
+int main() {
+    demo();
+    benchmark();
+    return 0;
+}
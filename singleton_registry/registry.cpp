@@ -0,0 +1,251 @@
+#include "registry.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <system_error>
+
+SingletonRegistry::~SingletonRegistry()
+{
+    // A destructor must not throw, that would be std::terminate
+    // If shutdown() fails, whatever is left is destroyed with "components", in no particular order
+    try {
+        shutdown();
+    }
+    catch (...) {
+    }
+}
+
+SingletonRegistry::Component &SingletonRegistry::find(const std::string &name)
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    auto it = index.find(name);
+    if (it == index.end()) {
+        throw std::invalid_argument("no singleton called \"" + name + "\"");
+    }
+    return components[it->second];
+}
+
+void SingletonRegistry::run_graph(const std::vector<std::vector<std::size_t>> &waits_for, unsigned threads,
+                                  const std::function<void(std::size_t)> &task)
+{
+    const std::size_t n = waits_for.size();
+    if (n == 0) {
+        return;
+    }
+
+    // Reverse the edges: who is waiting for each node
+    std::vector<std::vector<std::size_t>> waiters(n);
+    std::vector<std::size_t> remaining(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        remaining[i] = waits_for[i].size();
+        for (std::size_t before : waits_for[i]) {
+            waiters[before].push_back(i);
+        }
+    }
+
+    // Everything below is protected by graph_mut
+    std::mutex graph_mut;
+    std::condition_variable graph_cv;
+    std::deque<std::size_t> ready;
+    std::size_t finished {0};
+    std::exception_ptr error;
+
+    for (std::size_t i = 0; i < n; ++i) {
+        if (remaining[i] == 0) {
+            ready.push_back(i);
+        }
+    }
+
+    auto worker = [&] () {
+        std::unique_lock<std::mutex> uniq_lck(graph_mut);
+        while (true) {
+            graph_cv.wait(uniq_lck, [&] {return !ready.empty() || finished == n || error;});
+            if (finished == n || error) {
+                return;
+            }
+            std::size_t node = ready.front();
+            ready.pop_front();
+            uniq_lck.unlock();
+
+            std::exception_ptr task_error;
+            try {
+                task(node);
+            }
+            catch (...) {
+                task_error = std::current_exception();
+            }
+
+            uniq_lck.lock();
+            ++finished;
+            if (task_error) {
+                if (!error) {
+                    error = task_error;
+                }
+            }
+            else {
+                for (std::size_t next : waiters[node]) {
+                    if (--remaining[next] == 0) {
+                        ready.push_back(next);
+                    }
+                }
+            }
+            graph_cv.notify_all();
+        }
+    };
+
+    threads = static_cast<unsigned>(std::clamp<std::size_t>(threads, 1, n));
+    std::vector<std::thread> pool;
+    for (unsigned t = 1; t < threads; ++t) {
+        try {
+            pool.emplace_back(worker);
+        }
+        catch (const std::system_error &) {
+            // Out of threads: carry on with the ones we have, the calling thread alone is enough
+            break;
+        }
+    }
+    worker(); // the calling thread works too
+    for (auto &thr : pool) {
+        thr.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void SingletonRegistry::start(unsigned threads)
+{
+    std::vector<std::vector<std::size_t>> waits_for;
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (started) {
+            throw std::logic_error("start() called twice");
+        }
+
+        // Resolve the names, and check for cycles before building anything
+        waits_for.resize(components.size());
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            for (const std::string &dep : components[i].dependencies) {
+                auto it = index.find(dep);
+                if (it == index.end()) {
+                    throw std::invalid_argument("\"" + components[i].name + "\" depends on unknown singleton \"" + dep + "\"");
+                }
+                waits_for[i].push_back(it->second);
+            }
+        }
+
+        // Kahn's algorithm: if some nodes never reach zero, they are on a cycle
+        std::vector<std::size_t> remaining(components.size());
+        std::vector<std::vector<std::size_t>> waiters(components.size());
+        std::vector<std::size_t> ready;
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            remaining[i] = waits_for[i].size();
+            for (std::size_t before : waits_for[i]) {
+                waiters[before].push_back(i);
+            }
+            if (remaining[i] == 0) {
+                ready.push_back(i);
+            }
+        }
+        std::size_t ordered {0};
+        while (!ready.empty()) {
+            std::size_t node = ready.back();
+            ready.pop_back();
+            ++ordered;
+            for (std::size_t next : waiters[node]) {
+                if (--remaining[next] == 0) {
+                    ready.push_back(next);
+                }
+            }
+        }
+        if (ordered != components.size()) {
+            std::string cycle;
+            for (std::size_t i = 0; i < components.size(); ++i) {
+                if (remaining[i] != 0) {
+                    cycle += (cycle.empty() ? "" : ", ") + components[i].name;
+                }
+            }
+            throw std::logic_error("dependency cycle between: " + cycle);
+        }
+
+        started = true;
+        built.clear();
+        destroyed.clear();
+    }
+
+    try {
+        run_graph(waits_for, threads, [this] (std::size_t i) {
+            // Build outside the lock, the factory may call get() for its dependencies
+            std::shared_ptr<void> instance = components[i].create(*this);
+
+            std::lock_guard<std::mutex> lck_guard(mut);
+            components[i].instance = std::move(instance);
+            built.push_back(i);
+        });
+    }
+    catch (...) {
+        // Do not leave half a program running
+        // The factory's exception is the one the caller needs, not a later one from the teardown
+        try {
+            shutdown(threads);
+        }
+        catch (...) {
+        }
+        throw;
+    }
+}
+
+void SingletonRegistry::shutdown(unsigned threads)
+{
+    std::vector<std::vector<std::size_t>> waits_for;
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (!started) {
+            return;
+        }
+        started = false;
+
+        // A singleton waits for everything that depends on it
+        waits_for.resize(components.size());
+        for (std::size_t i = 0; i < components.size(); ++i) {
+            for (const std::string &dep : components[i].dependencies) {
+                waits_for[index[dep]].push_back(i);
+            }
+        }
+    }
+
+    run_graph(waits_for, threads, [this] (std::size_t i) {
+        std::shared_ptr<void> instance;
+        {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            instance.swap(components[i].instance);
+            if (instance) {
+                destroyed.push_back(i);
+            }
+        }
+        // The destructor runs here, outside the lock
+    });
+}
+
+std::vector<std::string> SingletonRegistry::startup_order() const
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    std::vector<std::string> names;
+    for (std::size_t i : built) {
+        names.push_back(components[i].name);
+    }
+    return names;
+}
+
+std::vector<std::string> SingletonRegistry::shutdown_order() const
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    std::vector<std::string> names;
+    for (std::size_t i : destroyed) {
+        names.push_back(components[i].name);
+    }
+    return names;
+}
@@ -0,0 +1,130 @@
+#ifndef SINGLETON_REGISTRY_REGISTRY_H
+#define SINGLETON_REGISTRY_REGISTRY_H
+
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <typeindex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/*
+ * Singleton Registry
+ *
+ * - Singleton in local_thread_variables
+ *      - instance_ is created with new and never deleted
+ *      - There is no way to say "this singleton needs that one first"
+ *      - Or "shut this one down before that one"
+ * - number1()/number2() use function statics
+ *      - Destroyed at exit in reverse order of construction, which we do not control
+ *
+ * - A service has dozens of these: config, logging, metrics, connection pools, caches...
+ *      - Built one after another, cold start is the sum of all their constructors
+ *      - But most of them do not depend on each other
+ *
+ * - The registry
+ *      - Each singleton is added with a name, the names it depends on, and a factory
+ *      - start() builds them in parallel
+ *              - A singleton becomes ready to build when all its dependencies are built
+ *              - Like a dependency counter per singleton which counts down to zero
+ *      - shutdown() tears them down in parallel, in the reverse direction
+ *              - A singleton is destroyed only after everything that depends on it
+ *      - Cold start time becomes the longest chain of dependencies, not the sum
+ *
+ * - Errors
+ *      - Unknown dependency or a dependency cycle: start() throws before building anything
+ *      - A factory throws: start() stops scheduling, tears down what was built, rethrows
+ *      - get<T>() with the wrong type, or before the singleton is built: throws
+ *      - Not enough threads for shutdown(): it carries on with fewer, the destructor never throws
+ *      */
+
+class SingletonRegistry {
+public:
+    SingletonRegistry() = default;
+    SingletonRegistry(const SingletonRegistry &source) = delete;
+    SingletonRegistry &operator=(const SingletonRegistry &source) = delete;
+
+    ~SingletonRegistry();
+
+    // The factory is called as factory(registry) and returns std::unique_ptr<T>
+    // It may call registry.get<Dep>(name) for any of its declared dependencies
+    template <typename T, typename Factory>
+    void add(std::string name, std::vector<std::string> dependencies, Factory factory)
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (started) {
+            throw std::logic_error("cannot add \"" + name + "\" after start()");
+        }
+        if (index.count(name) != 0) {
+            throw std::invalid_argument("singleton \"" + name + "\" added twice");
+        }
+        index[name] = components.size();
+
+        Component component;
+        component.name = std::move(name);
+        component.dependencies = std::move(dependencies);
+        component.type = std::type_index(typeid(T));
+        component.create = [factory = std::move(factory)] (SingletonRegistry &registry) -> std::shared_ptr<void> {
+            std::unique_ptr<T> object = factory(registry);
+            return std::shared_ptr<T>(std::move(object));
+        };
+        components.push_back(std::move(component));
+    }
+
+    // Build everything, using up to "threads" threads
+    void start(unsigned threads = std::thread::hardware_concurrency());
+
+    // Destroy everything in dependency order, using up to "threads" threads
+    void shutdown(unsigned threads = std::thread::hardware_concurrency());
+
+    // The reference is valid until shutdown() destroys the singleton
+    // So get() must not race with shutdown(), and nothing may hold on to the reference past it
+    template <typename T>
+    T &get(const std::string &name)
+    {
+        Component &component = find(name);
+        if (component.type != std::type_index(typeid(T))) {
+            throw std::logic_error("singleton \"" + name + "\" is not of the requested type");
+        }
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (!component.instance) {
+            throw std::logic_error("singleton \"" + name + "\" has not been built");
+        }
+        return *static_cast<T *>(component.instance.get());
+    }
+
+    // Names in the order they finished being built / destroyed
+    std::vector<std::string> startup_order() const;
+    std::vector<std::string> shutdown_order() const;
+
+private:
+    struct Component {
+        std::string name;
+        std::vector<std::string> dependencies;
+        std::type_index type = std::type_index(typeid(void));
+        std::function<std::shared_ptr<void>(SingletonRegistry &)> create;
+        std::shared_ptr<void> instance;
+    };
+
+    mutable std::mutex mut;
+    std::vector<Component> components;
+    std::unordered_map<std::string, std::size_t> index;
+    bool started = false;
+
+    std::vector<std::size_t> built;        // indices, in build completion order
+    std::vector<std::size_t> destroyed;    // indices, in destruction order
+
+    Component &find(const std::string &name);
+
+    // Run "task" on every node, a node only once all of "waits_for[node]" have finished
+    // Stops at the first exception and rethrows it after the threads have been joined
+    static void run_graph(const std::vector<std::vector<std::size_t>> &waits_for, unsigned threads,
+                          const std::function<void(std::size_t)> &task);
+};
+
+#endif //SINGLETON_REGISTRY_REGISTRY_H
@@ -0,0 +1,73 @@
+#ifndef STOP_TOKEN_JOINING_THREAD_H
+#define STOP_TOKEN_JOINING_THREAD_H
+
+#include <thread>
+#include <type_traits>
+#include <utility>
+
+#include "stop_token.h"
+
+/*
+ * JoiningThread, std::jthread for C++17
+ *
+ * - A std::thread which is still joinable when it is destroyed calls std::terminate()
+ *      - So every early return or exception between starting and joining a thread ends the program
+ * - JoiningThread asks its thread to stop and joins it in the destructor
+ * - If the function takes a StopToken as its first argument, it gets the thread's token
+ *      - Otherwise it is called with just the arguments given, like std::thread
+ *      */
+
+class JoiningThread {
+private:
+    StopSource source;
+    std::thread thr;
+
+public:
+    JoiningThread() = default;
+
+    template <typename Fn, typename... Args>
+    explicit JoiningThread(Fn &&fn, Args &&...args)
+    {
+        if constexpr (std::is_invocable_v<std::decay_t<Fn>, StopToken, std::decay_t<Args>...>) {
+            thr = std::thread(std::forward<Fn>(fn), source.get_token(), std::forward<Args>(args)...);
+        }
+        else {
+            thr = std::thread(std::forward<Fn>(fn), std::forward<Args>(args)...);
+        }
+    }
+
+    ~JoiningThread()
+    {
+        if (thr.joinable()) {
+            source.request_stop();
+            thr.join();
+        }
+    }
+
+    JoiningThread(JoiningThread &&source_thread) noexcept = default;
+    JoiningThread &operator=(JoiningThread &&source_thread) noexcept
+    {
+        if (this != &source_thread) {
+            if (thr.joinable()) {
+                source.request_stop();
+                thr.join();
+            }
+            source = std::move(source_thread.source);
+            thr = std::move(source_thread.thr);
+        }
+        return *this;
+    }
+
+    JoiningThread(const JoiningThread &source_thread) = delete;
+    JoiningThread &operator=(const JoiningThread &source_thread) = delete;
+
+    bool request_stop() { return source.request_stop(); }
+    StopSource get_stop_source() const { return source; }
+    StopToken get_stop_token() const { return source.get_token(); }
+
+    bool joinable() const { return thr.joinable(); }
+    void join() { thr.join(); }
+    std::thread::id get_id() const { return thr.get_id(); }
+};
+
+#endif //STOP_TOKEN_JOINING_THREAD_H
@@ -0,0 +1,206 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <vector>
+
+#include "stop_token.h"
+#include "joining_thread.h"
+
+using namespace std::literals;
+
+/*
+ * fetch_data(), progress_bar() and process_data() from thread_synchronization, twice
+ *
+ * - With a shutdown flag, the usual fix without stop tokens
+ *      - The waits check the flag in their predicates and are notified when it is set
+ *      - The fetcher can only check it between its 2s sleeps
+ * - With stop tokens
+ *      - The sleep and the waits are interruptible, every thread returns as soon as it is asked
+ *      - JoiningThread asks and joins, so leaving the scope is the whole shutdown
+ *
+ * - Shutdown latency: from the request to the moment all three threads have been joined
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+struct Download {
+    std::string downloaded_data;
+    std::mutex data_lock;
+    std::condition_variable download_condition_variable;
+    bool string_updated = false;
+    bool download_complete = false;
+    bool shutdown = false;              // only used by the flag version
+    bool verbose = false;
+
+    std::mutex print_mut;
+
+    void print(const std::string &line)
+    {
+        if (verbose) {
+            std::lock_guard<std::mutex> lck_guard(print_mut);
+            std::cout << line << std::endl;
+        }
+    }
+
+    void add_block(int i)
+    {
+        std::lock_guard<std::mutex> lock_guard(data_lock);
+        downloaded_data += "Block" + std::to_string(i + 1);
+        string_updated = true;
+        download_condition_variable.notify_all();
+    }
+
+    void complete()
+    {
+        std::lock_guard<std::mutex> lock_guard(data_lock);
+        download_complete = true;
+        download_condition_variable.notify_all();
+    }
+};
+
+// The flag version
+
+void fetch_data_flag(Download &d, std::chrono::milliseconds block_time)
+{
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(block_time);
+        {
+            std::lock_guard<std::mutex> lock_guard(d.data_lock);
+            if (d.shutdown) {
+                return;
+            }
+        }
+        d.add_block(i);
+    }
+    d.complete();
+}
+
+void progress_bar_flag(Download &d)
+{
+    std::unique_lock<std::mutex> uniq_lck(d.data_lock);
+    while (!d.download_complete && !d.shutdown) {
+        d.download_condition_variable.wait_for(uniq_lck, 2s, [&d] {
+            return d.string_updated || d.download_complete || d.shutdown;
+        });
+        d.string_updated = false;
+    }
+}
+
+void process_data_flag(Download &d)
+{
+    std::unique_lock<std::mutex> uniq_lck(d.data_lock);
+    d.download_condition_variable.wait(uniq_lck, [&d] {return d.download_complete || d.shutdown;});
+}
+
+// The stop token version
+
+void fetch_data(StopToken token, Download &d, std::chrono::milliseconds block_time)
+{
+    d.print("Fetching Data...........");
+    for (int i = 0; i < 5; ++i) {
+        if (!interruptible_sleep_for(block_time, token)) {
+            d.print("Fetcher stopped after " + std::to_string(i) + " blocks");
+            return;
+        }
+        d.add_block(i);
+    }
+    d.complete();
+}
+
+void progress_bar(StopToken token, Download &d)
+{
+    std::unique_lock<std::mutex> uniq_lck(d.data_lock);
+    while (!d.download_complete) {
+        interruptible_wait_for(d.download_condition_variable, uniq_lck, 2s, token, [&d] {
+            return d.string_updated || d.download_complete;
+        });
+        if (token.stop_requested()) {
+            uniq_lck.unlock();
+            d.print("Progress bar stopped");
+            return;
+        }
+        d.string_updated = false;
+        std::size_t len = d.downloaded_data.size();
+        uniq_lck.unlock();
+        d.print("Received " + std::to_string(len) + " bytes so far.....");
+        uniq_lck.lock();
+    }
+}
+
+void process_data(StopToken token, Download &d)
+{
+    std::unique_lock<std::mutex> uniq_lck(d.data_lock);
+    if (!interruptible_wait(d.download_condition_variable, uniq_lck, token, [&d] {return d.download_complete;})) {
+        uniq_lck.unlock();
+        d.print("Processing stopped, nothing to process");
+        return;
+    }
+    std::string data = d.downloaded_data;
+    uniq_lck.unlock();
+    d.print("Processing data: " + data);
+}
+
+double shutdown_with_flag(std::chrono::milliseconds block_time, std::chrono::milliseconds stop_after)
+{
+    Download d;
+    std::thread fetcher(fetch_data_flag, std::ref(d), block_time);
+    std::thread prog(progress_bar_flag, std::ref(d));
+    std::thread processor(process_data_flag, std::ref(d));
+
+    std::this_thread::sleep_for(stop_after);
+    auto start = bench_clock::now();
+    {
+        std::lock_guard<std::mutex> lock_guard(d.data_lock);
+        d.shutdown = true;
+        d.download_condition_variable.notify_all();
+    }
+    fetcher.join();
+    prog.join();
+    processor.join();
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+double shutdown_with_tokens(std::chrono::milliseconds block_time, std::chrono::milliseconds stop_after,
+                            bool verbose = false)
+{
+    Download d;
+    d.verbose = verbose;
+    bench_clock::time_point start;
+    {
+        std::vector<JoiningThread> threads;
+        threads.emplace_back(fetch_data, std::ref(d), block_time);
+        threads.emplace_back(progress_bar, std::ref(d));
+        threads.emplace_back(process_data, std::ref(d));
+
+        std::this_thread::sleep_for(stop_after);
+        start = bench_clock::now();
+        for (auto &thr : threads) {
+            thr.request_stop();
+        }
+        // ~JoiningThread joins
+    }
+    return std::chrono::duration<double, std::micro>(bench_clock::now() - start).count();
+}
+
+int main() {
+    std::cout << "Stop after 3s, blocks of 2s" << std::endl;
+    double us = shutdown_with_tokens(2s, 3s, true);
+    std::cout << "Shutdown took " << us << "us" << std::endl;
+
+    std::cout << "\n" << std::left << std::setw(14) << "version" << std::right << std::setw(12) << "stop after"
+              << std::setw(18) << "shutdown us" << std::endl;
+    for (auto stop_after : {300ms, 1300ms}) {
+        std::cout << std::left << std::setw(14) << "flag" << std::right << std::setw(10) << stop_after.count() << "ms"
+                  << std::fixed << std::setprecision(1) << std::setw(18) << shutdown_with_flag(2s, stop_after)
+                  << std::defaultfloat << std::endl;
+        std::cout << std::left << std::setw(14) << "stop token" << std::right << std::setw(10) << stop_after.count()
+                  << "ms" << std::fixed << std::setprecision(1) << std::setw(18)
+                  << shutdown_with_tokens(2s, stop_after) << std::defaultfloat << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include "stop_token.h"
+
+class StopState {
+public:
+    std::atomic<bool> requested {false};
+
+    std::mutex mut;
+    std::condition_variable callback_done;
+    std::list<StopCallback *> callbacks;
+    StopCallback *running = nullptr;
+    std::thread::id running_thread;
+
+    bool request_stop()
+    {
+        std::unique_lock<std::mutex> uniq_lck(mut);
+        if (requested.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        requested.store(true, std::memory_order_release);
+        running_thread = std::this_thread::get_id();
+
+        // One at a time, without the lock: a callback may register or unregister others
+        while (!callbacks.empty()) {
+            StopCallback *callback = callbacks.front();
+            callbacks.pop_front();
+            callback->registered = false;
+            running = callback;
+            uniq_lck.unlock();
+            callback->fn();
+            uniq_lck.lock();
+            running = nullptr;
+            callback_done.notify_all();
+        }
+        return true;
+    }
+
+    // false if stop was requested already, then the caller runs the callback itself
+    bool add(StopCallback *callback)
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        if (requested.load(std::memory_order_relaxed)) {
+            return false;
+        }
+        callback->position = callbacks.insert(callbacks.end(), callback);
+        callback->registered = true;
+        return true;
+    }
+
+    void remove(StopCallback *callback)
+    {
+        std::unique_lock<std::mutex> uniq_lck(mut);
+        if (callback->registered) {
+            callbacks.erase(callback->position);
+            callback->registered = false;
+            return;
+        }
+        // Running on another thread: wait, or it would use a destroyed callback
+        // On our own thread it is the callback destroying itself, waiting would never end
+        if (running == callback && running_thread != std::this_thread::get_id()) {
+            callback_done.wait(uniq_lck, [this, callback] {return running != callback;});
+        }
+    }
+};
+
+bool StopToken::stop_requested() const
+{
+    return state && state->requested.load(std::memory_order_acquire);
+}
+
+StopSource::StopSource() : state(std::make_shared<StopState>())
+{
+}
+
+bool StopSource::request_stop()
+{
+    return state && state->request_stop();
+}
+
+bool StopSource::stop_requested() const
+{
+    return state && state->requested.load(std::memory_order_acquire);
+}
+
+StopCallback::StopCallback(const StopToken &token, std::function<void()> callback)
+        : state(token.state), fn(std::move(callback))
+{
+    if (state && !state->add(this)) {
+        fn();
+    }
+}
+
+StopCallback::~StopCallback()
+{
+    if (state) {
+        state->remove(this);
+    }
+}
+
+bool interruptible_sleep_for(std::chrono::steady_clock::duration duration, const StopToken &token)
+{
+    std::mutex mut;
+    std::condition_variable cv;
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    interruptible_wait_for(cv, uniq_lck, duration, token, [] {return false;});
+    return !token.stop_requested();
+}
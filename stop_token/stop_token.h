@@ -0,0 +1,145 @@
+#ifndef STOP_TOKEN_STOP_TOKEN_H
+#define STOP_TOKEN_STOP_TOKEN_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/*
+ * Cooperative Cancellation
+ *
+ * - fetch_data() sleeps for 2s at a time, process_data() waits on a condition variable
+ *      until the download is complete: there is no way to tell them to stop early
+ *      - Shutting down means waiting for the current sleep to end, or for ever
+ * - C++20 has std::stop_source, std::stop_token and std::jthread, these do the same in C++17
+ *
+ * - StopSource: the side that asks for the stop, request_stop()
+ * - StopToken: the side that is asked, stop_requested()
+ *      - Both share one StopState, tokens are cheap to copy
+ * - StopCallback: runs a function when stop is requested
+ *      - Straight away in the constructor if it already has been
+ *      - Otherwise on the thread that calls request_stop()
+ *      - The destructor unregisters it, and waits if it is running on another thread at that moment,
+ *              so whatever the callback uses stays alive until it is done
+ *
+ * - Checking stop_requested() in a loop is not enough for a thread that is blocked
+ *      - interruptible_sleep_for() returns early on a stop
+ *      - interruptible_wait() and interruptible_wait_for() wait on a condition variable
+ *              until the predicate is true or a stop is requested
+ *      - Both register a StopCallback which wakes the waiting thread
+ *
+ * - Cooperative: nothing is killed, the thread notices and returns by itself,
+ *      so its locks are released and its destructors run
+ *      */
+
+class StopState;
+class StopCallback;
+
+class StopToken {
+private:
+    std::shared_ptr<StopState> state;
+
+    friend class StopSource;
+    friend class StopCallback;
+    explicit StopToken(std::shared_ptr<StopState> shared_state) : state(std::move(shared_state)) {}
+
+public:
+    // A token with no source, it is never stopped
+    StopToken() = default;
+
+    bool stop_requested() const;
+    bool stop_possible() const { return state != nullptr; }
+};
+
+class StopSource {
+private:
+    std::shared_ptr<StopState> state;
+
+public:
+    StopSource();
+
+    StopToken get_token() const { return StopToken(state); }
+
+    // Runs the registered callbacks, returns false if stop had been requested already
+    bool request_stop();
+    bool stop_requested() const;
+};
+
+class StopCallback {
+private:
+    std::shared_ptr<StopState> state;
+    std::function<void()> fn;
+    std::list<StopCallback *>::iterator position;
+    bool registered = false;
+
+    friend class StopState;
+
+public:
+    StopCallback(const StopToken &token, std::function<void()> callback);
+    ~StopCallback();
+
+    StopCallback(const StopCallback &source) = delete;
+    StopCallback &operator=(const StopCallback &source) = delete;
+};
+
+// Returns false if it was woken early by a stop
+bool interruptible_sleep_for(std::chrono::steady_clock::duration duration, const StopToken &token);
+
+// The callback takes the waiter's mutex before it notifies,
+// so the wakeup cannot fall between the waiter's check and its wait
+// Do not call request_stop() while holding that mutex
+template <typename Predicate>
+bool interruptible_wait_until(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                              std::chrono::steady_clock::time_point deadline, const StopToken &token,
+                              Predicate pred)
+{
+    if (pred() || token.stop_requested()) {
+        return pred();
+    }
+
+    // The lock is let go while the callback is registered and unregistered,
+    // as the callback needs it and may be running at that moment
+    std::mutex &mut = *lock.mutex();
+    lock.unlock();
+    {
+        StopCallback wake(token, [&cv, &mut] {
+            std::lock_guard<std::mutex> lck_guard(mut);
+            cv.notify_all();
+        });
+        lock.lock();
+        while (!pred() && !token.stop_requested()) {
+            // time_point::max() means no timeout, it is not passed on as a deadline as it could overflow
+            if (deadline == std::chrono::steady_clock::time_point::max()) {
+                cv.wait(lock);
+            }
+            else if (cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+                break;
+            }
+        }
+        lock.unlock();
+    }
+    lock.lock();
+    return pred();
+}
+
+// Returns pred(): false means it stopped waiting because of a stop request (or the timeout)
+template <typename Predicate>
+bool interruptible_wait(std::condition_variable &cv, std::unique_lock<std::mutex> &lock, const StopToken &token,
+                        Predicate pred)
+{
+    return interruptible_wait_until(cv, lock, std::chrono::steady_clock::time_point::max(), token, pred);
+}
+
+template <typename Predicate>
+bool interruptible_wait_for(std::condition_variable &cv, std::unique_lock<std::mutex> &lock,
+                            std::chrono::steady_clock::duration timeout, const StopToken &token, Predicate pred)
+{
+    return interruptible_wait_until(cv, lock, std::chrono::steady_clock::now() + timeout, token, pred);
+}
+
+#endif //STOP_TOKEN_STOP_TOKEN_H
@@ -0,0 +1,147 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <vector>
+#include <atomic>
+#include <algorithm>
+
+#include "worker_pool.h"
+#include "task_graph.h"
+
+using namespace std::literals;
+
+/*
+ * fetch_data(), progress_bar() and process_data() from thread_synchronization, as a graph
+ * - Each block is a task, which waits for the block before it
+ * - Each progress update waits for its block
+ * - Processing waits for the last block
+ * - No flags, no condition variables: the edges are the synchronisation
+ *      - Every block has its own slot, so no mutex is needed for the data either
+ *      - Only std::cout is still shared
+ * - The sleeps are 100ms instead of 2s
+ *      */
+
+std::mutex print_mut;
+
+void print(const std::string &line)
+{
+    std::lock_guard<std::mutex> lck_guard(print_mut);
+    std::cout << line << std::endl;
+}
+
+void download_example()
+{
+    const int block_count = 5;
+    std::vector<std::string> blocks(block_count);
+
+    TaskGraph graph;
+    TaskGraph::TaskId previous {0};
+    for (int i = 0; i < block_count; ++i) {
+        auto fetch = [&blocks, i] {
+            std::this_thread::sleep_for(100ms);
+            blocks[i] = "Block" + std::to_string(i + 1);
+        };
+        TaskGraph::TaskId block = i == 0 ? graph.add("fetch 1", fetch)
+                                         : graph.add("fetch " + std::to_string(i + 1), fetch, {previous});
+
+        graph.add("progress " + std::to_string(i + 1), [&blocks, i] {
+            std::size_t len {0};
+            for (int b = 0; b <= i; ++b) {
+                len += blocks[b].size();
+            }
+            print("Received " + std::to_string(len) + " bytes so far");
+        }, {block});
+        previous = block;
+    }
+    graph.add("process", [&blocks] {
+        std::string data;
+        for (auto &block : blocks) {
+            data += block;
+        }
+        print("Processing data: " + data);
+    }, {previous});
+
+    WorkerPool pool(4);
+    graph.run(pool);
+}
+
+/*
+ * Scheduling overhead
+ * - Every task is empty, so the time is all graph and pool
+ * - wide: a root, n tasks which only depend on the root, a sink which depends on all of them
+ *      - Tests handing tasks to the pool, and the sink's counter which every task decrements
+ * - deep: a chain of n tasks, each depending on the one before
+ *      - Nothing can run in parallel, continuation means it never touches a queue
+ * - submit: n empty tasks given straight to the pool, for comparison
+ * - Best of 5 runs of the same graph, in ns per task
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+template <typename Body>
+double best_ns_per_task(std::size_t n, Body body)
+{
+    double best {1e300};
+    for (int rep = 0; rep < 5; ++rep) {
+        auto start = bench_clock::now();
+        body();
+        double ns = std::chrono::duration<double, std::nano>(bench_clock::now() - start).count();
+        best = std::min(best, ns / static_cast<double>(n));
+    }
+    return best;
+}
+
+void print_row(const std::string &shape, std::size_t n, unsigned workers, double ns)
+{
+    std::cout << std::left << std::setw(8) << shape << std::right << std::setw(10) << n << std::setw(9) << workers
+              << std::fixed << std::setprecision(1) << std::setw(14) << ns << std::defaultfloat << std::endl;
+}
+
+void benchmark(std::size_t n, unsigned workers)
+{
+    WorkerPool pool(workers);
+
+    TaskGraph wide;
+    TaskGraph::TaskId root = wide.add("root", [] {});
+    std::vector<TaskGraph::TaskId> middle;
+    for (std::size_t i = 0; i < n; ++i) {
+        middle.push_back(wide.add("task", [] {}, {root}));
+    }
+    wide.add("sink", [] {}, middle);
+    print_row("wide", n, workers, best_ns_per_task(wide.size(), [&] {wide.run(pool);}));
+
+    TaskGraph deep;
+    TaskGraph::TaskId last = deep.add("task", [] {});
+    for (std::size_t i = 1; i < n; ++i) {
+        last = deep.add("task", [] {}, {last});
+    }
+    print_row("deep", n, workers, best_ns_per_task(deep.size(), [&] {deep.run(pool);}));
+
+    print_row("submit", n, workers, best_ns_per_task(n, [&] {
+        std::atomic<std::size_t> done {0};
+        for (std::size_t i = 0; i < n; ++i) {
+            pool.submit([&done] {done.fetch_add(1, std::memory_order_release);});
+        }
+        pool.wait_until([&] {return done.load(std::memory_order_acquire) == n;});
+    }));
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(download_example);
+    thread4.join();
+
+    std::size_t max_tasks = argc > 1 ? std::stoul(argv[1]) : 100000;
+
+    std::cout << "\n" << std::left << std::setw(8) << "shape" << std::right << std::setw(10) << "tasks"
+              << std::setw(9) << "workers" << std::setw(14) << "ns per task" << std::endl;
+    for (std::size_t n = 1000; n <= max_tasks; n *= 10) {
+        for (unsigned workers = 1; workers <= std::max(1u, std::thread::hardware_concurrency()); workers *= 2) {
+            benchmark(n, workers);
+        }
+    }
+
+    return 0;
+}
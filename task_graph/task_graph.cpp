@@ -0,0 +1,100 @@
+#include "task_graph.h"
+
+#include <stdexcept>
+
+TaskGraph::TaskId TaskGraph::add(std::string name, std::function<void()> fn,
+                                 std::initializer_list<TaskId> predecessors)
+{
+    return add(std::move(name), std::move(fn), std::vector<TaskId>(predecessors));
+}
+
+TaskGraph::TaskId TaskGraph::add(std::string name, std::function<void()> fn, const std::vector<TaskId> &predecessors)
+{
+    TaskId id = nodes.size();
+    for (TaskId pred : predecessors) {
+        if (pred >= id) {
+            throw std::out_of_range("TaskGraph::add: unknown predecessor " + std::to_string(pred) + " for " + name);
+        }
+    }
+
+    auto node = std::make_unique<Node>();
+    node->name = std::move(name);
+    node->fn = std::move(fn);
+    node->predecessor_count = static_cast<int>(predecessors.size());
+    nodes.push_back(std::move(node));
+    for (TaskId pred : predecessors) {
+        nodes[pred]->successors.push_back(id);
+    }
+    return id;
+}
+
+void TaskGraph::submit(TaskId id)
+{
+    pool->submit([this, id] {execute(id);});
+}
+
+void TaskGraph::execute(TaskId id)
+{
+    while (true) {
+        Node &node = *nodes[id];
+        if (!failed.load(std::memory_order_relaxed)) {
+            try {
+                node.fn();
+            }
+            catch (...) {
+                std::lock_guard<std::mutex> lck_guard(error_mut);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                failed.store(true, std::memory_order_relaxed);
+            }
+        }
+
+        // Release the successors, keep one of them to run here
+        bool have_next = false;
+        TaskId next = 0;
+        for (TaskId succ : node.successors) {
+            if (nodes[succ]->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                if (have_next) {
+                    submit(next);
+                }
+                next = succ;
+                have_next = true;
+            }
+        }
+
+        unfinished.fetch_sub(1, std::memory_order_release);
+        if (!have_next) {
+            return;
+        }
+        id = next;
+    }
+}
+
+void TaskGraph::run(WorkerPool &on_pool)
+{
+    if (nodes.empty()) {
+        return;
+    }
+
+    pool = &on_pool;
+    failed.store(false, std::memory_order_relaxed);
+    error = nullptr;
+    unfinished.store(nodes.size(), std::memory_order_relaxed);
+    for (auto &node : nodes) {
+        node->remaining.store(node->predecessor_count, std::memory_order_relaxed);
+    }
+
+    // The counters must all be set before the first task can decrement one
+    for (TaskId id = 0; id < nodes.size(); ++id) {
+        if (nodes[id]->predecessor_count == 0) {
+            submit(id);
+        }
+    }
+
+    on_pool.wait_until([this] {return unfinished.load(std::memory_order_acquire) == 0;});
+    pool = nullptr;
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef TASK_GRAPH_TASK_GRAPH_H
+#define TASK_GRAPH_TASK_GRAPH_H
+
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "worker_pool.h"
+
+/*
+ * Dependency-counted Task Graph
+ *
+ * - fetch_data(), progress_bar() and process_data() encode "what runs after what" with flags,
+ *      a mutex and condition variables, and every thread sits blocked until its turn
+ * - A task graph says it directly: each task lists the tasks it has to wait for
+ *      - graph.add("process", process, {fetch})
+ *      - No thread blocks, a task is only handed to the pool once it can run
+ *
+ * - Every task has an atomic counter of unfinished predecessors
+ *      - Set to the number of predecessors at the start of run()
+ *      - A finishing task decrements the counter of each of its successors
+ *      - Whoever takes a counter to zero makes that successor runnable
+ *              - fetch_sub with acq_rel: that thread sees everything every predecessor wrote
+ *      - Tasks with no predecessors are submitted straight away
+ *
+ * - Continuation
+ *      - Of the successors a task makes runnable, one is run straight away on the same thread
+ *              and only the others are submitted to the pool
+ *      - A chain a -> b -> c never goes through a queue, and b finds a's data still in the cache
+ *
+ * - Predecessors must be added before their successors, so a cycle cannot be built
+ * - The same graph can be run again, the counters are reset by run()
+ * - If a task throws, the tasks which have not started yet are skipped and run() rethrows
+ *      */
+
+class TaskGraph {
+public:
+    using TaskId = std::size_t;
+
+private:
+    struct Node {
+        std::string name;
+        std::function<void()> fn;
+        std::vector<TaskId> successors;
+        int predecessor_count = 0;
+        std::atomic<int> remaining {0};
+    };
+
+    // unique_ptr, as the atomic counters cannot be moved when the vector grows
+    std::vector<std::unique_ptr<Node>> nodes;
+
+    // State of the current run()
+    WorkerPool *pool = nullptr;
+    std::atomic<std::size_t> unfinished {0};
+    std::atomic<bool> failed {false};
+    std::mutex error_mut;
+    std::exception_ptr error;
+
+    void execute(TaskId id);
+    void submit(TaskId id);
+
+public:
+    TaskGraph() = default;
+    TaskGraph(const TaskGraph &source) = delete;
+    TaskGraph &operator=(const TaskGraph &source) = delete;
+
+    // Throws std::out_of_range if a predecessor has not been added yet
+    TaskId add(std::string name, std::function<void()> fn, std::initializer_list<TaskId> predecessors = {});
+    TaskId add(std::string name, std::function<void()> fn, const std::vector<TaskId> &predecessors);
+
+    // Runs every task once, and returns when all of them have finished
+    // The calling thread runs tasks too while it waits
+    void run(WorkerPool &pool = WorkerPool::shared());
+
+    std::size_t size() const { return nodes.size(); }
+    const std::string &name(TaskId id) const { return nodes.at(id)->name; }
+};
+
+#endif //TASK_GRAPH_TASK_GRAPH_H
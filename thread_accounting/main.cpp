@@ -0,0 +1,101 @@
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <condition_variable>
+#include <atomic>
+
+#include "thread_accounting.h"
+
+using namespace std::literals;
+
+/*
+ * fetch_data(), progress_bar() and process_data() from thread_synchronization, with accounting
+ * - The sleeps are 200ms instead of 2s
+ * - progress_bar() checks for completion every 10ms, so it wakes up far more often than the others
+ * - A fourth thread polls a flag in a loop, to show what a busy thread looks like
+ *      */
+
+std::string downloaded_data;
+std::mutex data_lock;
+std::condition_variable download_condition_variable;
+bool string_updated = false;
+bool download_complete = false;
+std::atomic<bool> all_done {false};
+
+void fetch_data()
+{
+    ThreadAccount account("fetch_data");
+    for (int i = 0; i < 5; ++i) {
+        std::this_thread::sleep_for(200ms);
+        std::lock_guard<std::mutex> lock_guard(data_lock);
+        downloaded_data += "Block" + std::to_string(i+1);
+        string_updated = true;
+        download_condition_variable.notify_all();
+    }
+    std::lock_guard<std::mutex> final_lock_guard(data_lock);
+    download_complete = true;
+    download_condition_variable.notify_all();
+}
+
+void progress_bar()
+{
+    ThreadAccount account("progress_bar");
+    while (true) {
+        std::unique_lock<std::mutex> uniq_lck(data_lock);
+        download_condition_variable.wait_for(uniq_lck, 10ms, [] {return string_updated || download_complete;});
+        string_updated = false;
+        if (download_complete) {
+            break;
+        }
+    }
+}
+
+void process_data()
+{
+    ThreadAccount account("process_data");
+    std::unique_lock<std::mutex> uniq_lck(data_lock);
+    download_condition_variable.wait(uniq_lck, [] {return download_complete;});
+
+    // A little real work on the result
+    std::size_t checksum {0};
+    for (int round = 0; round < 20000; ++round) {
+        for (char c : downloaded_data) {
+            checksum = checksum * 31 + c;
+        }
+    }
+    volatile std::size_t keep = checksum;
+    (void)keep;
+}
+
+void busy_poller()
+{
+    ThreadAccount account("busy_poller");
+    while (!all_done.load()) {
+        // Spins instead of waiting: all CPU, no useful work
+    }
+}
+
+int main() {
+    ThreadAccount account("main");
+    print_thread_table_at_exit();
+
+    std::thread poller(busy_poller);
+    std::thread fetcher(fetch_data);
+    std::thread prog(progress_bar);
+    std::thread processor(process_data);
+
+    // On demand, while the threads are still running
+    std::this_thread::sleep_for(500ms);
+    std::cout << "Threads after 500ms:" << std::endl;
+    print_thread_table(std::cout);
+
+    fetcher.join();
+    prog.join();
+    processor.join();
+    all_done = true;
+    poller.join();
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+#include "thread_accounting.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+struct AccountEntry {
+    std::string name;
+    long tid = 0;
+    bool running = true;
+    std::chrono::steady_clock::time_point start;
+#if defined(__linux__)
+    clockid_t cpu_clock {};
+#endif
+    // The thread's totals when it registered, it may have run for a while before that
+    double start_cpu_seconds = 0;
+    std::uint64_t start_voluntary = 0;
+    std::uint64_t start_involuntary = 0;
+    ThreadStats final_stats {};
+};
+
+struct AccountRegistry {
+    std::mutex mut;
+    std::vector<AccountEntry> entries;
+};
+
+// Never destroyed, so it can still be read from an atexit handler
+static AccountRegistry &account_registry()
+{
+    static AccountRegistry *reg = new AccountRegistry;
+    return *reg;
+}
+
+static void read_context_switches(long tid, std::uint64_t &voluntary, std::uint64_t &involuntary)
+{
+    voluntary = 0;
+    involuntary = 0;
+#if defined(__linux__)
+    std::ifstream status("/proc/self/task/" + std::to_string(tid) + "/status");
+    std::string line;
+    while (std::getline(status, line)) {
+        std::size_t colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        std::string key = line.substr(0, colon);
+        if (key == "voluntary_ctxt_switches") {
+            voluntary = std::stoull(line.substr(colon + 1));
+        }
+        else if (key == "nonvoluntary_ctxt_switches") {
+            involuntary = std::stoull(line.substr(colon + 1));
+        }
+    }
+#else
+    (void)tid;
+#endif
+}
+
+static double read_cpu_seconds(const AccountEntry &entry)
+{
+#if defined(__linux__)
+    timespec ts {};
+    if (clock_gettime(entry.cpu_clock, &ts) == 0) {
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+    }
+#else
+    (void)entry;
+#endif
+    return 0;
+}
+
+// Only for a thread which is still running, called with the registry locked
+// Everything counts from the moment the thread registered, like the wall time
+static ThreadStats sample(const AccountEntry &entry)
+{
+    ThreadStats stats {};
+    stats.name = entry.name;
+    stats.tid = entry.tid;
+    stats.running = true;
+    stats.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - entry.start).count();
+    stats.cpu_seconds = read_cpu_seconds(entry) - entry.start_cpu_seconds;
+    read_context_switches(entry.tid, stats.voluntary_switches, stats.involuntary_switches);
+    // A failed read gives zeros, don't let that wrap around
+    stats.voluntary_switches -= std::min(stats.voluntary_switches, entry.start_voluntary);
+    stats.involuntary_switches -= std::min(stats.involuntary_switches, entry.start_involuntary);
+    return stats;
+}
+
+ThreadAccount::ThreadAccount(const std::string &name)
+{
+    AccountEntry entry;
+    entry.name = name;
+    entry.start = std::chrono::steady_clock::now();
+#if defined(__linux__)
+    entry.tid = static_cast<long>(syscall(SYS_gettid));
+    pthread_getcpuclockid(pthread_self(), &entry.cpu_clock);
+#endif
+    entry.start_cpu_seconds = read_cpu_seconds(entry);
+    read_context_switches(entry.tid, entry.start_voluntary, entry.start_involuntary);
+
+    AccountRegistry &reg = account_registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    index = reg.entries.size();
+    reg.entries.push_back(std::move(entry));
+}
+
+ThreadAccount::~ThreadAccount()
+{
+    AccountRegistry &reg = account_registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    AccountEntry &entry = reg.entries[index];
+    // Last chance: after this the thread's CPU clock may no longer exist
+    entry.final_stats = sample(entry);
+    entry.final_stats.running = false;
+    entry.running = false;
+}
+
+std::vector<ThreadStats> thread_stats()
+{
+    AccountRegistry &reg = account_registry();
+    std::lock_guard<std::mutex> lck_guard(reg.mut);
+    std::vector<ThreadStats> stats;
+    for (auto &entry : reg.entries) {
+        stats.push_back(entry.running ? sample(entry) : entry.final_stats);
+    }
+    return stats;
+}
+
+void print_thread_table(std::ostream &os)
+{
+    os << std::left << std::setw(20) << "thread" << std::right << std::setw(8) << "tid" << std::setw(10) << "state"
+       << std::setw(11) << "wall ms" << std::setw(11) << "cpu ms" << std::setw(12) << "blocked ms"
+       << std::setw(7) << "cpu%" << std::setw(11) << "voluntary" << std::setw(13) << "involuntary" << std::endl;
+    std::ios_base::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    os << std::fixed << std::setprecision(1);
+    for (auto &s : thread_stats()) {
+        double cpu_percent = s.wall_seconds > 0 ? 100.0 * s.cpu_seconds / s.wall_seconds : 0.0;
+        os << std::left << std::setw(20) << s.name << std::right << std::setw(8) << s.tid
+           << std::setw(10) << (s.running ? "running" : "done")
+           << std::setw(11) << s.wall_seconds * 1000 << std::setw(11) << s.cpu_seconds * 1000
+           << std::setw(12) << s.blocked_seconds() * 1000 << std::setw(7) << cpu_percent
+           << std::setw(11) << s.voluntary_switches << std::setw(13) << s.involuntary_switches << std::endl;
+    }
+    os.flags(flags);
+    os.precision(precision);
+}
+
+static void print_at_exit()
+{
+    std::cout << "\nThreads at exit:" << std::endl;
+    print_thread_table(std::cout);
+}
+
+void print_thread_table_at_exit()
+{
+    static std::once_flag installed;
+    std::call_once(installed, [] {std::atexit(print_at_exit);});
+}
@@ -0,0 +1,66 @@
+#ifndef THREAD_ACCOUNTING_THREAD_ACCOUNTING_H
+#define THREAD_ACCOUNTING_THREAD_ACCOUNTING_H
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/*
+ * Where Does Each Thread's Time Go?
+ *
+ * - fetch_data(), progress_bar() and process_data() all live for about the same wall time
+ *      - But fetch_data() mostly sleeps, process_data() mostly waits on a condition variable
+ *      - A thread which polls in a loop burns CPU while doing nothing useful
+ * - Per thread we want
+ *      - wall time: since the thread registered
+ *      - CPU time: time actually spent running, from the thread's CPU-time clock
+ *              - pthread_getcpuclockid() gives a clock for any thread, read it with clock_gettime()
+ *      - blocked time: wall - CPU, sleeping, waiting for a lock, or waiting to be scheduled
+ *      - context switches, from /proc/self/task/<tid>/status
+ *              - voluntary: the thread blocked (sleep, mutex, condition variable, I/O)
+ *              - involuntary: the scheduler took the CPU away (time slice used up, preempted)
+ *              - Lots of involuntary switches: more runnable threads than CPUs
+ *
+ * - A thread opts in with a ThreadAccount object at the top of its function
+ *      - When the object is destroyed (the thread is finishing), the numbers are frozen
+ *      - The thread's CPU clock is gone once the thread has exited
+ * - thread_stats() reads live threads' numbers at any time, print_thread_table() formats them
+ * - print_thread_table_at_exit() prints the table when the program ends
+ *      - Only Linux has the /proc numbers, elsewhere they are 0
+ *      */
+
+struct ThreadStats {
+    std::string name;
+    long tid;
+    bool running;
+    double wall_seconds;
+    double cpu_seconds;
+    std::uint64_t voluntary_switches;
+    std::uint64_t involuntary_switches;
+
+    double blocked_seconds() const { return wall_seconds > cpu_seconds ? wall_seconds - cpu_seconds : 0.0; }
+};
+
+// Registers the calling thread for as long as the object lives
+class ThreadAccount {
+private:
+    std::size_t index;
+
+public:
+    explicit ThreadAccount(const std::string &name);
+    ~ThreadAccount();
+
+    ThreadAccount(const ThreadAccount &source) = delete;
+    ThreadAccount &operator=(const ThreadAccount &source) = delete;
+};
+
+// Every thread registered so far, running or finished
+std::vector<ThreadStats> thread_stats();
+
+void print_thread_table(std::ostream &os);
+
+// Print the table to std::cout when main() returns or exit() is called
+void print_thread_table_at_exit();
+
+#endif //THREAD_ACCOUNTING_THREAD_ACCOUNTING_H
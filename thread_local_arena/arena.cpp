@@ -0,0 +1,79 @@
+#include "arena.h"
+
+#include <algorithm>
+
+// Header at the front of every chunk, the usable memory follows it
+struct Arena::Chunk {
+    Chunk *next;
+    std::size_t size;
+
+    char *data()
+    {
+        return reinterpret_cast<char *>(this + 1);
+    }
+};
+
+Arena::Arena(std::size_t chunk_size) : chunk_size(chunk_size) {}
+
+Arena::~Arena()
+{
+    Chunk *chunk = first;
+    while (chunk) {
+        Chunk *next = chunk->next;
+        ::operator delete(chunk);
+        chunk = next;
+    }
+}
+
+void *Arena::allocate_slow(std::size_t bytes, std::size_t alignment)
+{
+    // Move on to the next chunk which is big enough
+    // Chunks after "current" are free: they were used before the last rewind
+    Chunk *candidate = current ? current->next : first;
+    Chunk *last = current;
+    while (candidate) {
+        std::size_t pad = (alignment - reinterpret_cast<std::size_t>(candidate->data()) % alignment) % alignment;
+        if (candidate->size >= pad + bytes) {
+            current = candidate;
+            position = candidate->data() + pad + bytes;
+            end = candidate->data() + candidate->size;
+            return candidate->data() + pad;
+        }
+        last = candidate;
+        candidate = candidate->next;
+    }
+
+    // No free chunk is big enough, add a new one at the end of the list
+    // Oversized requests get a chunk of their own size
+    std::size_t size = std::max(chunk_size, bytes + alignment);
+    Chunk *chunk = static_cast<Chunk *>(::operator new(sizeof(Chunk) + size));
+    chunk->next = nullptr;
+    chunk->size = size;
+    reserved += size;
+
+    if (last) {
+        last->next = chunk;
+    }
+    else {
+        first = chunk;
+    }
+
+    std::size_t pad = (alignment - reinterpret_cast<std::size_t>(chunk->data()) % alignment) % alignment;
+    current = chunk;
+    position = chunk->data() + pad + bytes;
+    end = chunk->data() + size;
+    return chunk->data() + pad;
+}
+
+void Arena::rewind(Marker marker)
+{
+    current = static_cast<Chunk *>(marker.chunk);
+    position = marker.position;
+    end = current ? current->data() + current->size : nullptr;
+}
+
+Arena &thread_arena()
+{
+    thread_local Arena arena;
+    return arena;
+}
@@ -0,0 +1,156 @@
+#ifndef THREAD_LOCAL_ARENA_ARENA_H
+#define THREAD_LOCAL_ARENA_ARENA_H
+
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+/*
+ * Thread-local Arena Allocator
+ *
+ * - main() in local_thread_variables does
+ *      double *my_double = new double(12.8);
+ *      ...
+ *      delete my_double;
+ * - process() does "new Test"
+ * - Each new/delete goes through the global heap
+ *      - The heap must be thread-safe, so there is locking or at least atomics inside
+ *      - It keeps track of every block so that it can be freed on its own
+ *
+ * - Most small allocations in a request only live until the request ends
+ *
+ * - Bump-pointer arena
+ *      - Grab a big chunk of memory up front
+ *      - To allocate: round the pointer up to the alignment, move it forward by the size
+ *      - Individual deallocation does nothing
+ *      - At the end of the request, move the pointer back to where it started
+ *              - Everything allocated during the request is freed at once
+ *      - When a chunk is full, move on to the next one (allocated once, then reused)
+ *
+ * - One arena per thread (thread_local)
+ *      - Only its own thread touches it, so no locking at all
+ *
+ * - ArenaScope
+ *      - RAII: remembers the position when created, rewinds to it when destroyed
+ *      - Scopes nest, like the stack
+ *
+ * - ArenaResource
+ *      - An std::pmr::memory_resource which allocates from an arena
+ *      - std::pmr::vector<int> v(&resource); uses the arena for its buffer
+ *
+ * - Rules
+ *      - Objects with non-trivial destructors must still be destroyed (the arena only frees memory)
+ *      - Nothing allocated inside a scope may be used after the scope ends
+ *      - Memory must not be handed to another thread to be used after the scope ends
+ *      */
+
+class Arena {
+public:
+    // Where the arena is up to, see mark() and rewind()
+    struct Marker {
+        void *chunk;
+        char *position;
+    };
+
+    explicit Arena(std::size_t chunk_size = 64 * 1024);
+    ~Arena();
+
+    Arena(const Arena &source) = delete;
+    Arena &operator=(const Arena &source) = delete;
+
+    void *allocate(std::size_t bytes, std::size_t alignment = alignof(std::max_align_t))
+    {
+        // Fast path: the request fits in the current chunk
+        std::size_t pad = (alignment - reinterpret_cast<std::size_t>(position) % alignment) % alignment;
+        if (position && static_cast<std::size_t>(end - position) >= pad + bytes) {
+            void *result = position + pad;
+            position += pad + bytes;
+            return result;
+        }
+        return allocate_slow(bytes, alignment);
+    }
+
+    template <typename T, typename... Args>
+    T *make(Args &&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    Marker mark() const
+    {
+        return {current, position};
+    }
+
+    // Free everything allocated since the marker was taken
+    void rewind(Marker marker);
+
+    // Free everything, keep the chunks for reuse
+    void reset()
+    {
+        rewind({nullptr, nullptr});
+    }
+
+    // Total size of the chunks this arena owns
+    std::size_t bytes_reserved() const
+    {
+        return reserved;
+    }
+
+private:
+    struct Chunk;
+
+    std::size_t chunk_size;
+    Chunk *first = nullptr;
+    Chunk *current = nullptr;
+    char *position = nullptr;
+    char *end = nullptr;
+    std::size_t reserved {0};
+
+    void *allocate_slow(std::size_t bytes, std::size_t alignment);
+};
+
+// This thread's own arena
+Arena &thread_arena();
+
+class ArenaScope {
+private:
+    Arena &arena;
+    Arena::Marker marker;
+
+public:
+    explicit ArenaScope(Arena &arena = thread_arena()) : arena(arena), marker(arena.mark()) {}
+    ~ArenaScope()
+    {
+        arena.rewind(marker);
+    }
+
+    ArenaScope(const ArenaScope &source) = delete;
+    ArenaScope &operator=(const ArenaScope &source) = delete;
+};
+
+class ArenaResource : public std::pmr::memory_resource {
+private:
+    Arena &arena;
+
+public:
+    explicit ArenaResource(Arena &arena = thread_arena()) : arena(arena) {}
+
+private:
+    void *do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        return arena.allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void *, std::size_t, std::size_t) override
+    {
+        // Freed in bulk when the scope rewinds
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource &other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+#endif //THREAD_LOCAL_ARENA_ARENA_H
@@ -0,0 +1,162 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <memory_resource>
+
+#include "arena.h"
+
+/*
+ * my_vec() from Launching_thread, with the vector's buffer in the thread's arena
+ * - The scope frees the buffer (and the double) when the function returns
+ *      */
+void my_vec()
+{
+    ArenaScope scope;
+    ArenaResource resource;
+
+    std::pmr::vector<int> nums({1, 2, 3, 4}, &resource);
+    for (auto &value : nums) {
+        std::cout << "number: " << value << std::endl;
+    }
+
+    double *my_double = thread_arena().make<double>(12.8);
+    double mm {*my_double * 21.5};
+    std::cout << mm << std::endl;
+    // No delete: the memory goes back when scope is destroyed
+}
+
+/*
+ * Benchmark: a "request" which makes lots of small, short-lived allocations
+ * - 200 small objects of 16 to 128 bytes
+ * - A vector of ints which grows to 256 elements
+ * - Everything is freed when the request ends
+ *
+ * - Three ways to allocate
+ *      - global new/delete
+ *      - std::pmr::monotonic_buffer_resource, one per request, upstream is new/delete
+ *      - thread-local arena, one ArenaScope per request
+ * - N threads run requests at the same time
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+constexpr int small_objects = 200;
+constexpr int vector_size = 256;
+
+std::size_t object_size(int i)
+{
+    return 16 + (i * 37) % 113;
+}
+
+long request_new_delete()
+{
+    char *objects[small_objects];
+    for (int i = 0; i < small_objects; ++i) {
+        objects[i] = new char[object_size(i)];
+        objects[i][0] = static_cast<char>(i);
+    }
+    std::vector<int> vec;
+    for (int i = 0; i < vector_size; ++i) {
+        vec.push_back(i);
+    }
+
+    long sum = vec.back();
+    for (int i = 0; i < small_objects; ++i) {
+        sum += objects[i][0];
+        delete[] objects[i];
+    }
+    return sum;
+}
+
+long request_monotonic()
+{
+    std::pmr::monotonic_buffer_resource resource;
+    char *objects[small_objects];
+    for (int i = 0; i < small_objects; ++i) {
+        objects[i] = static_cast<char *>(resource.allocate(object_size(i), 1));
+        objects[i][0] = static_cast<char>(i);
+    }
+    std::pmr::vector<int> vec(&resource);
+    for (int i = 0; i < vector_size; ++i) {
+        vec.push_back(i);
+    }
+
+    long sum = vec.back();
+    for (int i = 0; i < small_objects; ++i) {
+        sum += objects[i][0];
+    }
+    return sum;
+}
+
+long request_arena()
+{
+    ArenaScope scope;
+    ArenaResource resource;
+    Arena &arena = thread_arena();
+
+    char *objects[small_objects];
+    for (int i = 0; i < small_objects; ++i) {
+        objects[i] = static_cast<char *>(arena.allocate(object_size(i), 1));
+        objects[i][0] = static_cast<char>(i);
+    }
+    std::pmr::vector<int> vec(&resource);
+    for (int i = 0; i < vector_size; ++i) {
+        vec.push_back(i);
+    }
+
+    long sum = vec.back();
+    for (int i = 0; i < small_objects; ++i) {
+        sum += objects[i][0];
+    }
+    return sum;
+}
+
+template <typename Request>
+double requests_per_second(int threads, int requests, Request request)
+{
+    std::vector<std::thread> workers;
+    auto start = bench_clock::now();
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([requests, request] {
+            long sink {0};
+            for (int r = 0; r < requests; ++r) {
+                sink += request();
+            }
+            volatile long keep = sink;
+            (void)keep;
+        });
+    }
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    double seconds = std::chrono::duration<double>(bench_clock::now() - start).count();
+    return threads * requests / seconds;
+}
+
+void benchmark(int requests)
+{
+    std::cout << "\nThousands of requests per second (" << small_objects << " small objects + a vector of "
+              << vector_size << " ints each)" << std::endl;
+    std::cout << std::setw(8) << "threads" << std::setw(16) << "new/delete" << std::setw(16) << "monotonic"
+              << std::setw(16) << "arena" << std::endl;
+
+    for (int threads : {1, 2, 4, 8, 16}) {
+        std::cout << std::setw(8) << threads
+                  << std::setw(16) << requests_per_second(threads, requests, request_new_delete) / 1000
+                  << std::setw(16) << requests_per_second(threads, requests, request_monotonic) / 1000
+                  << std::setw(16) << requests_per_second(threads, requests, request_arena) / 1000 << std::endl;
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(my_vec);
+    thread4.join();
+
+    int requests = argc > 1 ? std::stoi(argv[1]) : 5000;
+    benchmark(requests);
+
+    return 0;
+}
@@ -0,0 +1,144 @@
+#include "launcher.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <tuple>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+const char *placement_name(Placement placement)
+{
+    switch (placement) {
+        case Placement::os: return "os";
+        case Placement::compact: return "compact";
+        case Placement::scatter: return "scatter";
+        case Placement::physical_cores: return "physical_cores";
+        case Placement::one_per_llc: return "one_per_llc";
+    }
+    return "unknown";
+}
+
+// Neighbours first: node, socket, LLC, core, then the core's hardware threads
+static std::vector<CpuInfo> compact_order(std::vector<CpuInfo> cpus)
+{
+    std::sort(cpus.begin(), cpus.end(), [] (const CpuInfo &a, const CpuInfo &b) {
+        return std::tie(a.node, a.package, a.llc, a.core, a.smt_index, a.cpu)
+               < std::tie(b.node, b.package, b.llc, b.core, b.smt_index, b.cpu);
+    });
+    return cpus;
+}
+
+// One from each group in turn, until all groups are used up
+static std::vector<CpuInfo> round_robin(const std::map<int, std::vector<CpuInfo>> &groups)
+{
+    std::vector<CpuInfo> result;
+    bool took = true;
+    for (std::size_t i = 0; took; ++i) {
+        took = false;
+        for (auto &entry : groups) {
+            if (i < entry.second.size()) {
+                result.push_back(entry.second[i]);
+                took = true;
+            }
+        }
+    }
+    return result;
+}
+
+// Consecutive threads land on different sockets
+static std::vector<CpuInfo> interleave_packages(const std::vector<CpuInfo> &ordered)
+{
+    std::map<int, std::vector<CpuInfo>> by_package;
+    for (auto &info : ordered) {
+        by_package[info.package].push_back(info);
+    }
+    return round_robin(by_package);
+}
+
+std::vector<int> plan_placement(const CpuTopology &topo, int count, Placement placement)
+{
+    std::vector<CpuInfo> order;
+    switch (placement) {
+        case Placement::os:
+            break;
+
+        case Placement::compact:
+            order = compact_order(topo.cpus);
+            break;
+
+        case Placement::scatter: {
+            // Every core's first hardware thread before any sibling
+            // Within each SMT level, alternate between LLCs and between sockets
+            int max_smt {0};
+            for (auto &info : topo.cpus) {
+                max_smt = std::max(max_smt, info.smt_index);
+            }
+            for (int smt = 0; smt <= max_smt; ++smt) {
+                std::map<int, std::vector<CpuInfo>> by_llc;
+                for (auto &info : compact_order(topo.cpus)) {
+                    if (info.smt_index == smt) {
+                        by_llc[info.llc].push_back(info);
+                    }
+                }
+                std::vector<CpuInfo> level = interleave_packages(round_robin(by_llc));
+                order.insert(order.end(), level.begin(), level.end());
+            }
+            break;
+        }
+
+        case Placement::physical_cores:
+            for (auto &info : compact_order(topo.cpus)) {
+                if (info.smt_index == 0) {
+                    order.push_back(info);
+                }
+            }
+            break;
+
+        case Placement::one_per_llc: {
+            std::set<int> taken;
+            for (auto &info : compact_order(topo.cpus)) {
+                if (info.smt_index == 0 && taken.insert(info.llc).second) {
+                    order.push_back(info);
+                }
+            }
+            order = interleave_packages(order);
+            break;
+        }
+    }
+
+    std::vector<int> cpus(count, -1);
+    if (!order.empty()) {
+        for (int i = 0; i < count; ++i) {
+            cpus[i] = order[i % order.size()].cpu;
+        }
+    }
+    return cpus;
+}
+
+bool pin_current_thread(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+bool name_current_thread(const std::string &name)
+{
+#if defined(__linux__)
+    // 15 characters and the terminating zero
+    return pthread_setname_np(pthread_self(), name.substr(0, 15).c_str()) == 0;
+#else
+    (void)name;
+    return false;
+#endif
+}
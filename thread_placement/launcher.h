@@ -0,0 +1,71 @@
+#ifndef THREAD_PLACEMENT_LAUNCHER_H
+#define THREAD_PLACEMENT_LAUNCHER_H
+
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "topology.h"
+
+/*
+ * Launching Threads in the Right Place
+ *
+ * - std::thread thr(hello) in Launching_thread lets the OS pick a CPU, and change its mind later
+ *      - A thread that moves leaves its warm cache behind
+ *      - Two threads that talk a lot may end up on different sockets
+ *      - Two busy threads may end up as SMT siblings, sharing one core
+ *
+ * - Placement policies
+ *      - os:             no pinning, as before
+ *      - compact:        fill one core (all its hardware threads), then the next, then the next socket
+ *              - Threads which share data stay close: shared caches, cheap cache-line transfers
+ *      - scatter:        spread over sockets first, then over cores, SMT siblings last
+ *              - Most cache and memory bandwidth per thread, but sharing is expensive
+ *      - physical_cores: one thread per core, never two on SMT siblings
+ *      - one_per_llc:    one thread per last-level cache
+ *              - e.g. one worker per CCX on AMD, so each owns an L3
+ *      - With more threads than the policy has CPUs, it wraps around
+ *
+ * - Each thread is also given a name ("worker-3"), which shows up in top -H, gdb and perf
+ *      - Linux limits names to 15 characters
+ *      */
+
+enum class Placement {
+    os,
+    compact,
+    scatter,
+    physical_cores,
+    one_per_llc
+};
+
+const char *placement_name(Placement placement);
+
+// The CPU for each of "count" threads, -1 for "let the OS decide"
+std::vector<int> plan_placement(const CpuTopology &topo, int count, Placement placement);
+
+// Both return false if the OS refused, the thread just runs unpinned/unnamed then
+bool pin_current_thread(int cpu);
+bool name_current_thread(const std::string &name);
+
+// Starts body(index) on "count" threads, placed and named "<name>-<index>"
+// The caller joins them, as with any std::thread
+template <typename Body>
+std::vector<std::thread> launch_threads(int count, Placement placement, const std::string &name, Body body,
+                                        const CpuTopology &topo = read_cpu_topology())
+{
+    std::vector<int> cpus = plan_placement(topo, count, placement);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < count; ++i) {
+        threads.emplace_back([body, i, cpu = cpus[i], thread_name = name + "-" + std::to_string(i)] () mutable {
+            if (cpu >= 0) {
+                pin_current_thread(cpu);
+            }
+            name_current_thread(thread_name);
+            body(i);
+        });
+    }
+    return threads;
+}
+
+#endif //THREAD_PLACEMENT_LAUNCHER_H
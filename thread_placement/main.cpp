@@ -0,0 +1,165 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <vector>
+#include <queue>
+#include <string>
+#include <cstdint>
+
+#include "launcher.h"
+#include "latency_histogram.h"
+
+/*
+ * hello() from Launching_thread, started by the launcher instead of std::thread directly
+ *      */
+std::mutex print_mut;
+
+void hello(int index)
+{
+    std::lock_guard<std::mutex> lck_guard(print_mut);
+    std::cout << "Hello, Thread " << index << "! (" << std::this_thread::get_id() << ")" << std::endl;
+}
+
+void print_topology(const CpuTopology &topo)
+{
+    std::cout << topo.cpus.size() << " usable CPUs, " << topo.physical_cores() << " physical cores, "
+              << topo.llcs() << " last-level caches, " << topo.packages() << " sockets, "
+              << topo.nodes() << " NUMA nodes" << std::endl;
+    for (auto &info : topo.cpus) {
+        std::cout << "    cpu " << std::setw(3) << info.cpu << ": socket " << info.package << ", node " << info.node
+                  << ", llc " << info.llc << ", core " << info.core << ", smt " << info.smt_index << std::endl;
+    }
+}
+
+const Placement placements[] = {Placement::os, Placement::compact, Placement::scatter,
+                                Placement::physical_cores, Placement::one_per_llc};
+
+void print_plans(const CpuTopology &topo, int threads)
+{
+    for (Placement placement : placements) {
+        std::cout << "    " << std::left << std::setw(16) << placement_name(placement) << std::right;
+        for (int cpu : plan_placement(topo, threads, placement)) {
+            std::cout << std::setw(4) << cpu;
+        }
+        std::cout << std::endl;
+    }
+}
+
+// 2 sockets x 2 LLCs x 2 cores x 2 hardware threads, numbered the way Linux usually does:
+// cpus 0-7 are the first hardware thread of each core, 8-15 their siblings
+CpuTopology example_topology()
+{
+    CpuTopology topo;
+    for (int cpu = 0; cpu < 16; ++cpu) {
+        int core = cpu % 8;
+        topo.cpus.push_back(CpuInfo{cpu, core / 4, core, core % 4, core / 4, (core / 2) * 2, cpu / 8});
+    }
+    return topo;
+}
+
+/*
+ * Benchmarks, run under every placement
+ * - mutex: 4 threads take turns on one lock, how long does lock() take?
+ *      - compact keeps the lock's cache line within one core or LLC
+ * - queue: 1 producer, 1 consumer, how long from push to pop?
+ *      - The item and the queue's lock move from the producer's cache to the consumer's
+ * - On a machine with one CPU all placements look the same
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+std::uint64_t nanoseconds_since(bench_clock::time_point start)
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - start).count();
+}
+
+LatencyHistogram mutex_latency(const CpuTopology &topo, Placement placement, int threads, int locks)
+{
+    std::mutex mut;
+    long shared_counter {0};
+    LatencyRecorder recorder;
+    auto workers = launch_threads(threads, placement, "mutex", [&] (int) {
+        for (int i = 0; i < locks; ++i) {
+            auto start = bench_clock::now();
+            std::lock_guard<std::mutex> lck_guard(mut);
+            recorder.record(nanoseconds_since(start));
+            ++shared_counter;
+        }
+    }, topo);
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    return recorder.snapshot();
+}
+
+LatencyHistogram queue_latency(const CpuTopology &topo, Placement placement, int items)
+{
+    std::queue<bench_clock::time_point> q;
+    std::mutex m;
+    std::condition_variable cv;
+    LatencyHistogram latency;
+
+    auto workers = launch_threads(2, placement, "queue", [&] (int index) {
+        if (index == 0) {
+            for (int i = 0; i < items; ++i) {
+                {
+                    std::lock_guard<std::mutex> lock(m);
+                    q.push(bench_clock::now());
+                }
+                cv.notify_one();
+                if (i % 16 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+        else {
+            for (int i = 0; i < items; ++i) {
+                std::unique_lock<std::mutex> lock(m);
+                cv.wait(lock, [&] {return !q.empty();});
+                bench_clock::time_point pushed = q.front();
+                q.pop();
+                lock.unlock();
+                latency.record(nanoseconds_since(pushed));
+            }
+        }
+    }, topo);
+    for (auto &thr : workers) {
+        thr.join();
+    }
+    return latency;
+}
+
+int main(int argc, char *argv[]) {
+    CpuTopology topo = read_cpu_topology();
+
+    auto greeters = launch_threads(3, Placement::compact, "hello", hello, topo);
+    for (auto &thr : greeters) {
+        thr.join();
+    }
+
+    std::cout << "\nThis machine: ";
+    print_topology(topo);
+    std::cout << "CPUs for 8 threads:" << std::endl;
+    print_plans(topo, 8);
+
+    std::cout << "\nExample machine, 2 sockets x 2 LLCs x 2 cores x 2 hardware threads" << std::endl;
+    std::cout << "CPUs for 8 threads:" << std::endl;
+    print_plans(example_topology(), 8);
+
+    int operations = argc > 1 ? std::stoi(argv[1]) : 50'000;
+    std::cout << std::endl;
+    LatencyHistogram::print_summary_header(std::cout);
+    for (Placement placement : placements) {
+        mutex_latency(topo, placement, 4, operations)
+                .print_summary(std::cout, std::string("mutex, 4 threads, ") + placement_name(placement));
+    }
+    for (Placement placement : placements) {
+        queue_latency(topo, placement, operations)
+                .print_summary(std::cout, std::string("queue, 1 pair, ") + placement_name(placement));
+    }
+
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "topology.h"
+
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <utility>
+
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
+static const std::string sys_cpu = "/sys/devices/system/cpu/";
+static const std::string sys_node = "/sys/devices/system/node/";
+
+static bool read_file(const std::string &path, std::string &text)
+{
+    std::ifstream in(path);
+    if (!in) {
+        return false;
+    }
+    std::getline(in, text);
+    return true;
+}
+
+static int read_int(const std::string &path, int fallback)
+{
+    std::string text;
+    if (!read_file(path, text)) {
+        return fallback;
+    }
+    try {
+        return std::stoi(text);
+    }
+    catch (std::exception &) {
+        return fallback;
+    }
+}
+
+std::vector<int> parse_cpu_list(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::stringstream ss(text);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        if (range.empty() || range == "\n") {
+            continue;
+        }
+        std::size_t dash = range.find('-');
+        int first = std::stoi(range.substr(0, dash));
+        int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// CPUs which are online and in this process's affinity mask
+static std::vector<int> usable_cpus()
+{
+    std::vector<int> cpus;
+    std::string online;
+    if (read_file(sys_cpu + "online", online)) {
+        cpus = parse_cpu_list(online);
+    }
+    else {
+        for (unsigned cpu = 0; cpu < std::max(1u, std::thread::hardware_concurrency()); ++cpu) {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+
+#if defined(__linux__)
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+        cpus.erase(std::remove_if(cpus.begin(), cpus.end(), [&] (int cpu) {
+            return cpu >= CPU_SETSIZE || !CPU_ISSET(cpu, &allowed);
+        }), cpus.end());
+    }
+#endif
+    return cpus;
+}
+
+// The cache with the highest level this CPU has
+static int last_level_cache_group(int cpu)
+{
+    int best_level = -1;
+    int group = cpu;
+    for (int index = 0; ; ++index) {
+        std::string dir = sys_cpu + "cpu" + std::to_string(cpu) + "/cache/index" + std::to_string(index) + "/";
+        int level = read_int(dir + "level", -1);
+        if (level < 0) {
+            break;
+        }
+        std::string type, shared;
+        read_file(dir + "type", type);
+        if (type == "Instruction" || level <= best_level || !read_file(dir + "shared_cpu_list", shared)) {
+            continue;
+        }
+        std::vector<int> sharing = parse_cpu_list(shared);
+        if (!sharing.empty()) {
+            best_level = level;
+            group = *std::min_element(sharing.begin(), sharing.end());
+        }
+    }
+    return group;
+}
+
+CpuTopology read_cpu_topology()
+{
+    CpuTopology topo;
+    for (int cpu : usable_cpus()) {
+        std::string dir = sys_cpu + "cpu" + std::to_string(cpu) + "/topology/";
+        CpuInfo info {};
+        info.cpu = cpu;
+        info.package = read_int(dir + "physical_package_id", 0);
+        info.core_id = read_int(dir + "core_id", cpu);
+        info.core = cpu;
+        std::string siblings;
+        if (read_file(dir + "core_cpus_list", siblings) || read_file(dir + "thread_siblings_list", siblings)) {
+            std::vector<int> sharing = parse_cpu_list(siblings);
+            if (!sharing.empty()) {
+                info.core = *std::min_element(sharing.begin(), sharing.end());
+            }
+        }
+        info.node = 0;
+        info.llc = last_level_cache_group(cpu);
+        topo.cpus.push_back(info);
+    }
+
+    // NUMA nodes list their CPUs, not the other way round
+    for (int node = 0; ; ++node) {
+        std::string cpulist;
+        if (!read_file(sys_node + "node" + std::to_string(node) + "/cpulist", cpulist)) {
+            // Node numbers can have gaps, but not many
+            if (node > 64) {
+                break;
+            }
+            continue;
+        }
+        for (int cpu : parse_cpu_list(cpulist)) {
+            for (auto &info : topo.cpus) {
+                if (info.cpu == cpu) {
+                    info.node = node;
+                }
+            }
+        }
+    }
+
+    // Number the hardware threads of each core
+    for (auto &info : topo.cpus) {
+        int smt = 0;
+        for (auto &other : topo.cpus) {
+            if (other.cpu < info.cpu && other.core == info.core) {
+                ++smt;
+            }
+        }
+        info.smt_index = smt;
+    }
+    return topo;
+}
+
+template <typename Key>
+static int count_distinct(const std::vector<CpuInfo> &cpus, Key key)
+{
+    std::set<decltype(key(cpus.front()))> values;
+    for (auto &info : cpus) {
+        values.insert(key(info));
+    }
+    return static_cast<int>(values.size());
+}
+
+int CpuTopology::packages() const
+{
+    return count_distinct(cpus, [] (const CpuInfo &c) {return c.package;});
+}
+
+int CpuTopology::nodes() const
+{
+    return count_distinct(cpus, [] (const CpuInfo &c) {return c.node;});
+}
+
+int CpuTopology::physical_cores() const
+{
+    return count_distinct(cpus, [] (const CpuInfo &c) {return c.core;});
+}
+
+int CpuTopology::llcs() const
+{
+    return count_distinct(cpus, [] (const CpuInfo &c) {return c.llc;});
+}
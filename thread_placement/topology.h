@@ -0,0 +1,54 @@
+#ifndef THREAD_PLACEMENT_TOPOLOGY_H
+#define THREAD_PLACEMENT_TOPOLOGY_H
+
+#include <string>
+#include <vector>
+
+/*
+ * CPU Topology
+ *
+ * - "8 CPUs" is rarely 8 equal CPUs
+ *      - Hardware threads (SMT, hyper-threading): two logical CPUs share one core
+ *              - and its L1/L2 caches and execution units
+ *      - Cores share a last-level cache (LLC), a big machine has several LLCs
+ *      - Sockets (packages), each with its own memory: NUMA nodes
+ *              - Memory on the other node is slower, and so is a cache line owned by the other socket
+ *
+ * - Linux describes all of this under /sys/devices/system/cpu and /sys/devices/system/node
+ *      - cpuN/topology/physical_package_id, core_id
+ *      - cpuN/topology/core_cpus_list (thread_siblings_list on older kernels): the SMT siblings
+ *              - core_id is not unique within a package on some VMs, hybrid CPUs and ARM kernels,
+ *                      so cores are told apart by their sibling lists, core_id is only a label
+ *      - cpuN/cache/indexK/level and shared_cpu_list: which CPUs share that cache
+ *      - nodeM/cpulist: which CPUs belong to NUMA node M
+ *
+ * - Only CPUs which are online and which this process may run on are listed
+ *      - Containers and taskset often give us fewer than the machine has
+ * - If /sys can't be read, every CPU is reported as its own core on one node
+ *      */
+
+struct CpuInfo {
+    int cpu;
+    int package;
+    int core;           // lowest CPU number among this core's hardware threads
+    int core_id;        // the kernel's core_id, only a label
+    int node;
+    int llc;            // lowest CPU number sharing this CPU's last-level cache
+    int smt_index;      // 0 for the first hardware thread of a core, 1 for its sibling...
+};
+
+struct CpuTopology {
+    std::vector<CpuInfo> cpus;      // sorted by CPU number
+
+    int packages() const;
+    int nodes() const;
+    int physical_cores() const;
+    int llcs() const;
+};
+
+CpuTopology read_cpu_topology();
+
+// "0-3,8,10-11" -> {0, 1, 2, 3, 8, 10, 11}
+std::vector<int> parse_cpu_list(const std::string &text);
+
+#endif //THREAD_PLACEMENT_TOPOLOGY_H
@@ -0,0 +1,183 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <mutex>
+#include <string>
+#include <chrono>
+#include <future>
+#include <atomic>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+
+#include "worker_pool.h"
+#include "timing_wheel.h"
+#include "latency_histogram.h"
+
+using namespace std::literals;
+
+/*
+ * task1() and task2() from working_with_shared_data, with task2 on the timer service
+ * - task1 holds the mutex for 500ms
+ * - task2 tries to lock it every 100ms, but instead of sleeping on a thread of its own between tries,
+ *      each failed try schedules the next one
+ * - A 1s timeout is set up for task2, and cancelled when it gets the mutex
+ *      */
+
+std::mutex the_mutex;
+
+void task1()
+{
+    std::cout << "Task1 trying to lock the mutex" << std::endl;
+    std::lock_guard<std::mutex> lck_guard(the_mutex);
+    std::cout << "Task1 has locked the mutex" << std::endl;
+    std::this_thread::sleep_for(500ms);
+}
+
+void try_task2(TimingWheel &wheel, std::promise<void> &done)
+{
+    if (!the_mutex.try_lock()) {
+        std::cout << "Task2 could not lock the mutex" << std::endl;
+        wheel.schedule_after(100ms, [&wheel, &done] {try_task2(wheel, done);});
+        return;
+    }
+    std::cout << "Task2 has locked the mutex" << std::endl;
+    the_mutex.unlock();
+    done.set_value();
+}
+
+void task_example()
+{
+    WorkerPool pool(2);
+    TimingWheel wheel(1ms, &pool);
+
+    std::thread thr1(task1);
+    std::promise<void> done;
+    auto timeout = wheel.schedule_after(1s, [] {std::cout << "Task2 timed out" << std::endl;});
+    wheel.schedule_after(100ms, [&wheel, &done] {
+        std::cout << "Task2 trying to lock the mutex" << std::endl;
+        try_task2(wheel, done);
+    });
+
+    done.get_future().wait();
+    std::cout << "Timeout cancelled: " << (wheel.cancel(timeout) ? "yes" : "no") << std::endl;
+    thr1.join();
+}
+
+/*
+ * Benchmarks
+ * - insert and cancel: n timers due at random times from 1ms to 60s, then all cancelled in random order
+ *      - Against a std::multimap ordered by due time, which is what a timer queue usually is
+ *      - The multimap gets slower as it grows (O(log n), and a cache miss per level)
+ * - jitter: 10000 timers spread over 1s, each records how late it ran
+ *      - With a tick of 1ms and of 100us, callbacks on a pool and on the timer thread
+ *      - A timer is due on a tick boundary at the earliest, so lateness is up to one tick plus wakeup
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+double ns_per_op(bench_clock::time_point start, std::size_t ops)
+{
+    return std::chrono::duration<double, std::nano>(bench_clock::now() - start).count() / static_cast<double>(ops);
+}
+
+void insert_cancel_benchmark(std::size_t n)
+{
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<long long> delay_us(1000, 60000000);
+    std::vector<bench_clock::duration> delays;
+    for (std::size_t i = 0; i < n; ++i) {
+        delays.push_back(std::chrono::microseconds(delay_us(rng)));
+    }
+    std::vector<std::size_t> cancel_order(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        cancel_order[i] = i;
+    }
+    std::shuffle(cancel_order.begin(), cancel_order.end(), rng);
+
+    auto now = bench_clock::now();
+    std::cout << std::left << std::setw(12) << "structure" << std::right << std::setw(10) << "timers"
+              << std::setw(14) << "insert ns" << std::setw(14) << "cancel ns" << std::endl;
+
+    {
+        TimingWheel wheel;
+        std::vector<TimingWheel::TimerId> ids(n);
+        auto start = bench_clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            ids[i] = wheel.schedule_at(now + delays[i], [] {});
+        }
+        double insert_ns = ns_per_op(start, n);
+        start = bench_clock::now();
+        for (std::size_t i : cancel_order) {
+            wheel.cancel(ids[i]);
+        }
+        double cancel_ns = ns_per_op(start, n);
+        std::cout << std::left << std::setw(12) << "wheel" << std::right << std::setw(10) << n << std::fixed
+                  << std::setprecision(1) << std::setw(14) << insert_ns << std::setw(14) << cancel_ns
+                  << std::defaultfloat << std::endl;
+    }
+
+    {
+        std::mutex map_mut;
+        std::multimap<bench_clock::time_point, std::function<void()>> queue;
+        std::vector<decltype(queue)::iterator> ids(n);
+        auto start = bench_clock::now();
+        for (std::size_t i = 0; i < n; ++i) {
+            std::lock_guard<std::mutex> lck_guard(map_mut);
+            ids[i] = queue.emplace(now + delays[i], [] {});
+        }
+        double insert_ns = ns_per_op(start, n);
+        start = bench_clock::now();
+        for (std::size_t i : cancel_order) {
+            std::lock_guard<std::mutex> lck_guard(map_mut);
+            queue.erase(ids[i]);
+        }
+        double cancel_ns = ns_per_op(start, n);
+        std::cout << std::left << std::setw(12) << "multimap" << std::right << std::setw(10) << n << std::fixed
+                  << std::setprecision(1) << std::setw(14) << insert_ns << std::setw(14) << cancel_ns
+                  << std::defaultfloat << std::endl;
+    }
+}
+
+LatencyHistogram jitter(std::chrono::microseconds tick, WorkerPool *pool, int timers)
+{
+    LatencyRecorder lateness;
+    std::atomic<int> fired {0};
+    {
+        TimingWheel wheel(tick, pool);
+        std::mt19937_64 rng(7);
+        std::uniform_int_distribution<long long> delay_us(0, 1000000);
+        auto now = bench_clock::now();
+        for (int i = 0; i < timers; ++i) {
+            auto due = now + std::chrono::microseconds(delay_us(rng));
+            wheel.schedule_at(due, [&lateness, &fired, due] {
+                lateness.record(std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now() - due).count());
+                fired.fetch_add(1, std::memory_order_release);
+            });
+        }
+        while (fired.load(std::memory_order_acquire) < timers) {
+            std::this_thread::sleep_for(10ms);
+        }
+    }
+    return lateness.snapshot();
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(task_example);
+    thread4.join();
+
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    std::cout << std::endl;
+    insert_cancel_benchmark(n);
+
+    WorkerPool pool(2);
+    std::cout << "\n10000 timers over 1s, how late they ran" << std::endl;
+    LatencyHistogram::print_summary_header(std::cout);
+    jitter(1ms, &pool, 10000).print_summary(std::cout, "tick 1ms, pool");
+    jitter(100us, &pool, 10000).print_summary(std::cout, "tick 100us, pool");
+    jitter(1ms, nullptr, 10000).print_summary(std::cout, "tick 1ms, timer thread");
+
+    return 0;
+}
@@ -0,0 +1,209 @@
+#include "timing_wheel.h"
+
+#include <algorithm>
+
+TimingWheel::TimingWheel(std::chrono::microseconds tick, WorkerPool *dispatch_pool)
+        : tick_length(tick), start(clock::now()), pool(dispatch_pool)
+{
+    buckets.fill(nil);
+    thr = std::thread(&TimingWheel::timer_loop, this);
+}
+
+TimingWheel::~TimingWheel()
+{
+    {
+        std::lock_guard<std::mutex> lck_guard(mut);
+        stopping = true;
+    }
+    wake.notify_all();
+    thr.join();
+}
+
+std::uint64_t TimingWheel::tick_at(clock::time_point when) const
+{
+    if (when <= start) {
+        return 0;
+    }
+    return static_cast<std::uint64_t>((when - start) / tick_length);
+}
+
+// Puts a timer into the slot for its due tick, relative to now_tick
+void TimingWheel::link(std::uint32_t index)
+{
+    Timer &timer = timers[index];
+    std::size_t bucket = overflow_bucket;
+    for (int level = 0; level < level_count; ++level) {
+        // The lowest wheel on which the timer and the hand are in the same turn
+        int above = slot_bits * (level + 1);
+        if ((timer.due_tick >> above) == (now_tick >> above)) {
+            bucket = level * slot_count + ((timer.due_tick >> (slot_bits * level)) & (slot_count - 1));
+            break;
+        }
+    }
+
+    timer.bucket = static_cast<std::uint32_t>(bucket);
+    timer.prev = nil;
+    timer.next = buckets[bucket];
+    if (timer.next != nil) {
+        timers[timer.next].prev = index;
+    }
+    buckets[bucket] = index;
+}
+
+void TimingWheel::unlink(std::uint32_t index)
+{
+    Timer &timer = timers[index];
+    if (timer.prev != nil) {
+        timers[timer.prev].next = timer.next;
+    }
+    else {
+        buckets[timer.bucket] = timer.next;
+    }
+    if (timer.next != nil) {
+        timers[timer.next].prev = timer.prev;
+    }
+}
+
+void TimingWheel::release(std::uint32_t index)
+{
+    Timer &timer = timers[index];
+    timer.fn = nullptr;
+    timer.bucket = nil;
+    ++timer.generation;
+    timer.next = free_head;
+    free_head = index;
+    --pending_count;
+}
+
+void TimingWheel::cascade(std::size_t bucket)
+{
+    std::uint32_t index = buckets[bucket];
+    buckets[bucket] = nil;
+    while (index != nil) {
+        std::uint32_t next = timers[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+void TimingWheel::advance(std::uint64_t to_tick, std::vector<Callback> &due)
+{
+    while (now_tick < to_tick) {
+        if (pending_count == 0) {
+            now_tick = to_tick;
+            break;
+        }
+        ++now_tick;
+
+        // Higher wheels first, so what they move down is cascaded again by the wheels below
+        if ((now_tick & 0xffffffffULL) == 0) {
+            cascade(overflow_bucket);
+        }
+        for (int level = level_count - 1; level > 0; --level) {
+            std::uint64_t below = (std::uint64_t{1} << (slot_bits * level)) - 1;
+            if ((now_tick & below) == 0) {
+                cascade(level * slot_count + ((now_tick >> (slot_bits * level)) & (slot_count - 1)));
+            }
+        }
+
+        std::size_t bucket = now_tick & (slot_count - 1);
+        std::uint32_t index = buckets[bucket];
+        buckets[bucket] = nil;
+        while (index != nil) {
+            std::uint32_t next = timers[index].next;
+            due.push_back(std::move(timers[index].fn));
+            release(index);
+            index = next;
+        }
+    }
+}
+
+void TimingWheel::timer_loop()
+{
+    std::vector<Callback> due;
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    while (!stopping) {
+        if (pending_count == 0) {
+            wake.wait(uniq_lck, [this] {return stopping || pending_count > 0;});
+            continue;
+        }
+
+        clock::time_point next_tick = start + (now_tick + 1) * tick_length;
+        if (wake.wait_until(uniq_lck, next_tick, [this] {return stopping;})) {
+            break;
+        }
+        advance(tick_at(clock::now()), due);
+
+        if (!due.empty()) {
+            uniq_lck.unlock();
+            for (auto &fn : due) {
+                if (pool) {
+                    pool->submit(std::move(fn));
+                }
+                else {
+                    fn();
+                }
+            }
+            due.clear();
+            uniq_lck.lock();
+        }
+    }
+}
+
+TimingWheel::TimerId TimingWheel::schedule_at(clock::time_point when, Callback fn)
+{
+    // Rounded up: a timer never fires before its time
+    std::uint64_t due_tick = tick_at(when);
+    if (start + due_tick * tick_length < when) {
+        ++due_tick;
+    }
+
+    std::unique_lock<std::mutex> uniq_lck(mut);
+    bool was_empty = pending_count == 0;
+    if (was_empty) {
+        // The hand stands still while there are no timers, catch it up first
+        now_tick = std::max(now_tick, tick_at(clock::now()));
+    }
+
+    std::uint32_t index;
+    if (free_head != nil) {
+        index = free_head;
+        free_head = timers[index].next;
+    }
+    else {
+        index = static_cast<std::uint32_t>(timers.size());
+        timers.emplace_back();
+    }
+    Timer &timer = timers[index];
+    timer.fn = std::move(fn);
+    timer.due_tick = std::max(due_tick, now_tick + 1);
+    link(index);
+    ++pending_count;
+    TimerId id = (static_cast<TimerId>(timer.generation) << 32) | index;
+
+    uniq_lck.unlock();
+    if (was_empty) {
+        wake.notify_one();
+    }
+    return id;
+}
+
+bool TimingWheel::cancel(TimerId id)
+{
+    std::uint32_t index = static_cast<std::uint32_t>(id & 0xffffffffULL);
+    std::uint32_t generation = static_cast<std::uint32_t>(id >> 32);
+
+    std::lock_guard<std::mutex> lck_guard(mut);
+    if (index >= timers.size() || timers[index].bucket == nil || timers[index].generation != generation) {
+        return false;
+    }
+    unlink(index);
+    release(index);
+    return true;
+}
+
+std::size_t TimingWheel::pending()
+{
+    std::lock_guard<std::mutex> lck_guard(mut);
+    return pending_count;
+}
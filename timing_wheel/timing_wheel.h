@@ -0,0 +1,115 @@
+#ifndef TIMING_WHEEL_TIMING_WHEEL_H
+#define TIMING_WHEEL_TIMING_WHEEL_H
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "worker_pool.h"
+
+/*
+ * Hierarchical Timing Wheel
+ *
+ * - task2() retries every 100ms with sleep_for, reader_assignment() polls every 10ms,
+ *      fetch_data() and progress_bar() sleep or wait_for on threads of their own
+ *      - A whole thread per timeout, mostly asleep
+ * - A timer service: one thread keeps every timer, and runs their callbacks when they are due
+ *
+ * - A sorted container (std::multimap, a heap) costs O(log n) per insert and cancel
+ * - A timing wheel is a ring of slots, one per tick, like the face of a clock
+ *      - A timer due in 5 ticks goes into the list of the slot 5 steps ahead of the hand: O(1)
+ *      - Every tick the hand moves one slot on, and everything in that slot fires
+ *      - Cancel unlinks the timer from its slot's list: O(1)
+ *
+ * - Hierarchical: 4 wheels of 256 slots, like the hands of a clock
+ *      - Wheel 0 has one slot per tick, wheel 1 one slot per 256 ticks, wheel 2 one per 65536...
+ *      - A timer goes into the lowest wheel that can hold its due time
+ *      - When a wheel's hand completes a turn, the next slot of the wheel above is "cascaded":
+ *              its timers are moved down into the lower wheels
+ *      - Each timer is moved at most 3 times, so insert is still O(1) on average
+ *      - 2^32 ticks ahead at most, later timers wait in an overflow list
+ *
+ * - Timers live in one vector and the slot lists link them by index
+ *      - A TimerId is the index plus a generation, so cancelling a timer that has already fired
+ *              (and whose entry is reused) does nothing
+ *
+ * - Precision is one tick: a timer fires on the first tick at or after its due time
+ *      - The timer thread sleeps until the next tick while there are timers, and until
+ *              the first insert when there are none
+ *
+ * - Callbacks are handed to a WorkerPool, or run on the timer thread if there is none
+ *      - On the timer thread they must be short, or every other timer is late
+ * - The destructor drops the timers which have not fired
+ *      */
+
+class TimingWheel {
+public:
+    using Callback = std::function<void()>;
+    using clock = std::chrono::steady_clock;
+    using TimerId = std::uint64_t;
+
+    static constexpr int level_count = 4;
+    static constexpr int slot_bits = 8;
+    static constexpr std::size_t slot_count = std::size_t{1} << slot_bits;
+
+private:
+    static constexpr std::uint32_t nil = UINT32_MAX;
+    static constexpr std::size_t overflow_bucket = level_count * slot_count;
+
+    struct Timer {
+        Callback fn;
+        std::uint64_t due_tick = 0;
+        std::uint32_t prev = nil;
+        std::uint32_t next = nil;
+        std::uint32_t bucket = nil;         // nil while the entry is free
+        std::uint32_t generation = 1;
+    };
+
+    const clock::duration tick_length;
+    const clock::time_point start;
+    WorkerPool *pool;
+
+    std::mutex mut;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::vector<Timer> timers;
+    std::uint32_t free_head = nil;
+    std::array<std::uint32_t, overflow_bucket + 1> buckets;
+    std::uint64_t now_tick = 0;
+    std::size_t pending_count = 0;
+
+    std::thread thr;
+
+    std::uint64_t tick_at(clock::time_point when) const;
+    void link(std::uint32_t index);
+    void unlink(std::uint32_t index);
+    void release(std::uint32_t index);
+    void cascade(std::size_t bucket);
+    void advance(std::uint64_t to_tick, std::vector<Callback> &due);
+    void timer_loop();
+
+public:
+    explicit TimingWheel(std::chrono::microseconds tick = std::chrono::milliseconds(1), WorkerPool *pool = nullptr);
+    ~TimingWheel();
+
+    TimingWheel(const TimingWheel &source) = delete;
+    TimingWheel &operator=(const TimingWheel &source) = delete;
+
+    TimerId schedule_at(clock::time_point when, Callback fn);
+    TimerId schedule_after(clock::duration delay, Callback fn) { return schedule_at(clock::now() + delay, std::move(fn)); }
+
+    // true if the timer was still waiting, false if it has fired or was cancelled already
+    bool cancel(TimerId id);
+
+    std::size_t pending();
+    clock::duration tick() const { return tick_length; }
+};
+
+#endif //TIMING_WHEEL_TIMING_WHEEL_H
@@ -0,0 +1,180 @@
+#include <iostream>
+#include <iomanip>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <array>
+#include <string>
+#include <cstdint>
+#include <cmath>
+
+#include "worker_pool.h"
+#include "parallel.h"
+
+/*
+ * my_vec() from Launching_thread, with the loops run by the pool
+ *      */
+void my_vec()
+{
+    std::vector<int> nums {1, 2, 3, 4};
+    parallel_for(nums, [] (int &value) {value *= value;});
+    for (auto &value : nums) {
+        std::cout << "number: " << value << std::endl;
+    }
+    int sum = parallel_reduce(nums, 0, [] (int a, int b) {return a + b;});
+    std::cout << "sum of squares: " << sum << std::endl;
+
+    // Pieces are combined in order, so a non-commutative combine works
+    std::string letters = parallel_reduce(IndexRange{0, 26}, std::string(),
+                                          [] (IndexRange piece, std::string s) {
+                                              for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                                                  s += char('a' + i);
+                                              }
+                                              return s;
+                                          },
+                                          [] (std::string a, std::string b) {return a + b;}, 3);
+    std::cout << letters << std::endl;
+}
+
+/*
+ * Benchmarks
+ * - sum:       sum of a hash of every index, nothing in memory, pure compute
+ * - transform: out[i] = sqrt(in[i]) * 2 + 1, memory bandwidth
+ *              capped at 10^7 elements (160MB for both arrays)
+ * - histogram: 256 bins of a hash of every index, each piece fills its own bins and they are added up
+ * - Each is run sequentially, then with pools of 1, 2, 4... workers up to the number of hardware threads
+ *      */
+
+using bench_clock = std::chrono::steady_clock;
+
+inline std::uint64_t mix(std::uint64_t x)
+{
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    return x;
+}
+
+using Histogram = std::array<std::uint64_t, 256>;
+
+template <typename Body>
+double milliseconds(Body body)
+{
+    auto start = bench_clock::now();
+    body();
+    return std::chrono::duration<double, std::milli>(bench_clock::now() - start).count();
+}
+
+void print_row(const std::string &name, std::size_t n, const std::string &runner, double ms, double sequential_ms)
+{
+    std::cout << std::left << std::setw(11) << name << std::right << std::setw(12) << n << "  "
+              << std::left << std::setw(12) << runner << std::right << std::fixed << std::setprecision(2)
+              << std::setw(11) << ms << std::setw(9) << sequential_ms / ms << "x" << std::defaultfloat << std::endl;
+}
+
+void benchmark(std::size_t n, bool with_transform)
+{
+    std::vector<unsigned> pool_sizes;
+    for (unsigned k = 1; k <= std::max(1u, std::thread::hardware_concurrency()); k *= 2) {
+        pool_sizes.push_back(k);
+    }
+
+    // sum
+    volatile std::uint64_t sink {0};
+    double sequential = milliseconds([&] {
+        std::uint64_t total {0};
+        for (std::size_t i = 0; i < n; ++i) {
+            total += mix(i);
+        }
+        sink = total;
+    });
+    print_row("sum", n, "sequential", sequential, sequential);
+    for (unsigned k : pool_sizes) {
+        WorkerPool pool(k);
+        double ms = milliseconds([&] {
+            sink = parallel_reduce(IndexRange{0, n}, std::uint64_t{0},
+                                   [] (IndexRange piece, std::uint64_t acc) {
+                                       for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                                           acc += mix(i);
+                                       }
+                                       return acc;
+                                   },
+                                   [] (std::uint64_t a, std::uint64_t b) {return a + b;}, 0, pool);
+        });
+        print_row("sum", n, std::to_string(k) + " workers", ms, sequential);
+    }
+
+    // transform
+    if (with_transform) {
+        std::vector<double> in(n), out(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            in[i] = static_cast<double>(i);
+        }
+        sequential = milliseconds([&] {
+            for (std::size_t i = 0; i < n; ++i) {
+                out[i] = std::sqrt(in[i]) * 2 + 1;
+            }
+        });
+        print_row("transform", n, "sequential", sequential, sequential);
+        for (unsigned k : pool_sizes) {
+            WorkerPool pool(k);
+            double ms = milliseconds([&] {
+                parallel_for(IndexRange{0, n}, 0, [&] (std::size_t i) {out[i] = std::sqrt(in[i]) * 2 + 1;}, pool);
+            });
+            print_row("transform", n, std::to_string(k) + " workers", ms, sequential);
+        }
+    }
+
+    // histogram
+    Histogram expected {};
+    sequential = milliseconds([&] {
+        for (std::size_t i = 0; i < n; ++i) {
+            ++expected[mix(i) & 255];
+        }
+    });
+    print_row("histogram", n, "sequential", sequential, sequential);
+    for (unsigned k : pool_sizes) {
+        WorkerPool pool(k);
+        Histogram bins {};
+        double ms = milliseconds([&] {
+            bins = parallel_reduce(IndexRange{0, n}, Histogram{},
+                                   [] (IndexRange piece, Histogram h) {
+                                       for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                                           ++h[mix(i) & 255];
+                                       }
+                                       return h;
+                                   },
+                                   [] (Histogram a, const Histogram &b) {
+                                       for (std::size_t bin = 0; bin < a.size(); ++bin) {
+                                           a[bin] += b[bin];
+                                       }
+                                       return a;
+                                   }, 0, pool);
+        });
+        if (bins != expected) {
+            std::cout << "histogram mismatch!" << std::endl;
+        }
+        print_row("histogram", n, std::to_string(k) + " workers", ms, sequential);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    std::thread thread4(my_vec);
+    thread4.join();
+
+    // Elements go up to 10^max_exponent, 9 is allowed but takes a while
+    int max_exponent = argc > 1 ? std::stoi(argv[1]) : 7;
+
+    std::cout << "\n" << std::left << std::setw(11) << "benchmark" << std::right << std::setw(12) << "elements" << "  "
+              << std::left << std::setw(12) << "runner" << std::right << std::setw(11) << "ms" << std::setw(10) << "speedup"
+              << std::endl;
+    for (int e = 6; e <= max_exponent; ++e) {
+        std::size_t n = 1;
+        for (int i = 0; i < e; ++i) {
+            n *= 10;
+        }
+        benchmark(n, e <= 7);
+    }
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+#ifndef WORKER_POOL_PARALLEL_H
+#define WORKER_POOL_PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "worker_pool.h"
+
+/*
+ * parallel_for and parallel_reduce
+ *
+ * - my_vec() and ThreadSafeVector::print() walk their elements one at a time, on one thread
+ * - parallel_for(range, grain, fn) calls fn(i) for every i in the range, on all the pool's workers
+ * - parallel_reduce(range, identity, fold, combine) folds every piece of the range into a result
+ *      - fold(piece, acc) loops over the piece itself and returns the new acc
+ *              - Rather than being called once per index, so a big accumulator (an array of bins)
+ *                      is not copied for every element
+ *
+ * - Recursive splitting
+ *      - The range is cut in half, the right half becomes a task, the left half is cut again...
+ *      - ...until a piece is no bigger than the grain, which is then run as a loop
+ *      - The first split happens on the calling thread, so idle workers steal the big halves first
+ *              and split them further themselves: no single thread hands out all the pieces
+ *      - The caller runs pieces too while it waits (WorkerPool::wait_until)
+ *
+ * - Grain size
+ *      - Too small: the cost of a task (~100ns) is bigger than the work in it
+ *      - Too big: too few pieces to keep every worker busy until the end
+ *      - grain = 0 picks it automatically: about 8 pieces per worker
+ *
+ * - parallel_reduce keeps one partial result per piece and combines them in index order
+ *      - So combine only needs to be associative, not commutative
+ *      - e.g. string concatenation gives the same result as a sequential loop
+ *
+ * - If fn throws, the remaining pieces are skipped and the first exception is rethrown to the caller
+ *      */
+
+struct IndexRange {
+    std::size_t begin;
+    std::size_t end;
+
+    std::size_t size() const { return end > begin ? end - begin : 0; }
+};
+
+inline std::size_t auto_grain(std::size_t n, const WorkerPool &pool)
+{
+    std::size_t pieces = 8 * static_cast<std::size_t>(pool.size());
+    return std::max<std::size_t>(1, (n + pieces - 1) / pieces);
+}
+
+// State shared by all the pieces of one parallel call
+class ForkJoin {
+private:
+    std::mutex error_mut;
+    std::exception_ptr error;
+
+public:
+    std::atomic<std::size_t> pending {0};
+    std::atomic<bool> failed {false};
+
+    void fail(std::exception_ptr e)
+    {
+        std::lock_guard<std::mutex> lck_guard(error_mut);
+        if (!error) {
+            error = e;
+        }
+        failed.store(true, std::memory_order_relaxed);
+    }
+
+    void wait(WorkerPool &pool)
+    {
+        pool.wait_until([this] {return pending.load(std::memory_order_acquire) == 0;});
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+};
+
+template <typename Leaf>
+void split_range(WorkerPool &pool, IndexRange range, std::size_t grain, ForkJoin &fork_join, const Leaf &leaf)
+{
+    // Give the right half away, carry on with the left
+    while (range.size() > grain) {
+        std::size_t mid = range.begin + range.size() / 2;
+        IndexRange right {mid, range.end};
+        fork_join.pending.fetch_add(1, std::memory_order_relaxed);
+        pool.submit([&pool, right, grain, &fork_join, &leaf] {
+            split_range(pool, right, grain, fork_join, leaf);
+            fork_join.pending.fetch_sub(1, std::memory_order_release);
+        });
+        range.end = mid;
+    }
+
+    if (fork_join.failed.load(std::memory_order_relaxed)) {
+        return;
+    }
+    try {
+        leaf(range);
+    }
+    catch (...) {
+        fork_join.fail(std::current_exception());
+    }
+}
+
+template <typename Fn>
+void parallel_for(IndexRange range, std::size_t grain, Fn fn, WorkerPool &pool = WorkerPool::shared())
+{
+    if (range.size() == 0) {
+        return;
+    }
+    if (grain == 0) {
+        grain = auto_grain(range.size(), pool);
+    }
+
+    ForkJoin fork_join;
+    auto leaf = [&fn] (IndexRange piece) {
+        for (std::size_t i = piece.begin; i < piece.end; ++i) {
+            fn(i);
+        }
+    };
+    split_range(pool, range, grain, fork_join, leaf);
+    fork_join.wait(pool);
+}
+
+// fn(element) for every element of a random-access container
+template <typename Container, typename Fn>
+void parallel_for(Container &container, Fn fn, WorkerPool &pool = WorkerPool::shared())
+{
+    auto first = std::begin(container);
+    std::size_t n = static_cast<std::size_t>(std::distance(first, std::end(container)));
+    parallel_for(IndexRange{0, n}, 0, [&first, &fn] (std::size_t i) {fn(first[i]);}, pool);
+}
+
+// fold(IndexRange, T) -> T runs over each piece, combine(T, T) -> T joins the pieces' results
+template <typename T, typename Fold, typename Combine>
+T parallel_reduce(IndexRange range, T identity, Fold fold, Combine combine, std::size_t grain = 0,
+                  WorkerPool &pool = WorkerPool::shared())
+{
+    if (range.size() == 0) {
+        return identity;
+    }
+    if (grain == 0) {
+        grain = auto_grain(range.size(), pool);
+    }
+
+    std::mutex partial_mut;
+    std::vector<std::pair<std::size_t, T>> partials;
+
+    ForkJoin fork_join;
+    auto leaf = [&] (IndexRange piece) {
+        T acc = fold(piece, identity);
+        std::lock_guard<std::mutex> lck_guard(partial_mut);
+        partials.emplace_back(piece.begin, std::move(acc));
+    };
+    split_range(pool, range, grain, fork_join, leaf);
+    fork_join.wait(pool);
+
+    std::sort(partials.begin(), partials.end(), [] (const auto &a, const auto &b) {return a.first < b.first;});
+    T result = std::move(identity);
+    for (auto &partial : partials) {
+        result = combine(std::move(result), std::move(partial.second));
+    }
+    return result;
+}
+
+// op(T, T) -> T, both to fold elements in and to combine pieces
+template <typename Container, typename T, typename Op>
+T parallel_reduce(const Container &container, T identity, Op op, WorkerPool &pool = WorkerPool::shared())
+{
+    auto first = std::begin(container);
+    std::size_t n = static_cast<std::size_t>(std::distance(first, std::end(container)));
+    return parallel_reduce(IndexRange{0, n}, std::move(identity),
+                           [&first, &op] (IndexRange piece, T acc) {
+                               for (std::size_t i = piece.begin; i < piece.end; ++i) {
+                                   acc = op(std::move(acc), first[i]);
+                               }
+                               return acc;
+                           },
+                           op, 0, pool);
+}
+
+#endif //WORKER_POOL_PARALLEL_H
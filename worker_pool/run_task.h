@@ -0,0 +1,32 @@
+#ifndef WORKER_POOL_RUN_TASK_H
+#define WORKER_POOL_RUN_TASK_H
+
+#include <exception>
+#include <functional>
+#include <iostream>
+
+/*
+ * Tasks which Throw
+ *
+ * - submit() returns nothing, so nobody is waiting for the task and its exception has nowhere to go
+ * - Letting it out of the worker thread is std::terminate, for the whole program
+ * - So every pool (WorkerPool, PriorityPool, ElasticPool, ShardRuntime) runs its tasks through run_task()
+ *      - The exception is reported on std::cerr, and the worker carries on with the next task
+ * - To get the exception back, let the task carry it to whoever waits
+ *      - a std::packaged_task (ShardRuntime::submit_to), parallel_for/parallel_reduce, TaskGraph
+ *      */
+
+inline void run_task(const std::function<void()> &task, const char *pool_name)
+{
+    try {
+        task();
+    }
+    catch (const std::exception &e) {
+        std::cerr << pool_name << ": a task threw: " << e.what() << std::endl;
+    }
+    catch (...) {
+        std::cerr << pool_name << ": a task threw an exception" << std::endl;
+    }
+}
+
+#endif //WORKER_POOL_RUN_TASK_H
@@ -0,0 +1,147 @@
+#include "worker_pool.h"
+
+#include <algorithm>
+
+#include "run_task.h"
+
+// Which pool, and which worker in it, the calling thread is
+static thread_local const WorkerPool *this_thread_pool = nullptr;
+static thread_local int this_thread_index = -1;
+
+WorkerPool::WorkerPool(unsigned thread_count)
+{
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < thread_count; ++i) {
+        threads.emplace_back(&WorkerPool::worker_loop, this, static_cast<int>(i));
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lck_guard(global_mut);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto &thr : threads) {
+        thr.join();
+    }
+}
+
+int WorkerPool::current_worker() const
+{
+    return this_thread_pool == this ? this_thread_index : -1;
+}
+
+void WorkerPool::notify_sleepers()
+{
+    // Pairs with the sleeping/queued check in worker_loop: one of the two always sees the other
+    if (sleeping.load() > 0) {
+        std::lock_guard<std::mutex> lck_guard(global_mut);
+        wake.notify_one();
+    }
+}
+
+void WorkerPool::submit(Task task)
+{
+    queued.fetch_add(1);
+    int index = current_worker();
+    if (index >= 0) {
+        std::lock_guard<std::mutex> lck_guard(workers[index]->mut);
+        workers[index]->tasks.push_back(std::move(task));
+    }
+    else {
+        std::lock_guard<std::mutex> lck_guard(global_mut);
+        global_tasks.push_back(std::move(task));
+    }
+    notify_sleepers();
+}
+
+bool WorkerPool::take_task(int index, Task &task)
+{
+    if (queued.load(std::memory_order_relaxed) == 0) {
+        return false;
+    }
+
+    // Our own newest task first
+    if (index >= 0) {
+        Worker &own = *workers[index];
+        std::lock_guard<std::mutex> lck_guard(own.mut);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then work from outside the pool
+    {
+        std::lock_guard<std::mutex> lck_guard(global_mut);
+        if (!global_tasks.empty()) {
+            task = std::move(global_tasks.front());
+            global_tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+
+    // Then steal someone else's oldest task, starting with our neighbour
+    std::size_t n = workers.size();
+    std::size_t start = index >= 0 ? static_cast<std::size_t>(index) + 1 : 0;
+    for (std::size_t i = 0; i < n; ++i) {
+        Worker &victim = *workers[(start + i) % n];
+        std::lock_guard<std::mutex> lck_guard(victim.mut);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            queued.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool WorkerPool::run_one()
+{
+    Task task;
+    if (!take_task(current_worker(), task)) {
+        return false;
+    }
+    run_task(task, "WorkerPool");
+    return true;
+}
+
+void WorkerPool::worker_loop(int index)
+{
+    this_thread_pool = this;
+    this_thread_index = index;
+
+    Task task;
+    while (true) {
+        if (take_task(index, task)) {
+            run_task(task, "WorkerPool");
+            task = nullptr;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> uniq_lck(global_mut);
+        if (stopping && queued.load() == 0) {
+            break;
+        }
+        sleeping.fetch_add(1);
+        wake.wait(uniq_lck, [this] {return queued.load() > 0 || stopping;});
+        sleeping.fetch_sub(1);
+    }
+}
+
+WorkerPool &WorkerPool::shared()
+{
+    static WorkerPool pool;
+    return pool;
+}
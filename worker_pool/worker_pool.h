@@ -0,0 +1,97 @@
+#ifndef WORKER_POOL_WORKER_POOL_H
+#define WORKER_POOL_WORKER_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+ * Work-stealing Worker Pool
+ *
+ * - Starting a std::thread per piece of work costs tens of microseconds
+ *      - A pool starts its threads once, then hands them tasks
+ *
+ * - One shared queue is a bottleneck: every worker takes the same lock for every task
+ * - So each worker has its own deque
+ *      - A task submitted by a worker goes onto that worker's own deque
+ *      - The worker takes its newest task first (LIFO): its data is still in the cache
+ *      - An idle worker steals the oldest task from someone else (FIFO end)
+ *              - The oldest task is usually the biggest piece of a split-up range
+ *      - Tasks submitted from outside the pool go to a shared "injection" queue
+ *      - The deques are protected by a mutex each, there is hardly ever contention on them
+ *
+ * - Waiting inside a task
+ *      - A task which splits its work and waits for the pieces must not just block
+ *              - If every worker did that, nobody would be left to run the pieces
+ *      - wait_until(done) runs other tasks while it waits, so waiting is always safe
+ *
+ * - Idle workers sleep on a condition variable, and are woken when work is submitted
+ * - The destructor runs every task already submitted, then joins the threads
+ * - A task which throws is reported and skipped, see run_task.h
+ *      */
+
+class WorkerPool {
+public:
+    using Task = std::function<void()>;
+
+private:
+    struct Worker {
+        std::mutex mut;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::thread> threads;
+
+    std::mutex global_mut;
+    std::deque<Task> global_tasks;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::atomic<std::size_t> queued {0};    // tasks waiting in any queue
+    std::atomic<int> sleeping {0};          // workers inside wake.wait()
+
+    void worker_loop(int index);
+    bool take_task(int index, Task &task);
+    void notify_sleepers();
+
+public:
+    // 0 threads means one per hardware thread
+    explicit WorkerPool(unsigned thread_count = 0);
+    ~WorkerPool();
+
+    WorkerPool(const WorkerPool &source) = delete;
+    WorkerPool &operator=(const WorkerPool &source) = delete;
+
+    void submit(Task task);
+
+    // Runs one waiting task on the calling thread, returns false if there was none
+    bool run_one();
+
+    // Runs other tasks until done() is true
+    template <typename Predicate>
+    void wait_until(Predicate done)
+    {
+        while (!done()) {
+            if (!run_one()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
+    unsigned size() const { return static_cast<unsigned>(threads.size()); }
+
+    // Index of the calling thread in this pool, -1 if it is not one of its workers
+    int current_worker() const;
+
+    // The pool parallel_for() and friends use unless they are given another one
+    static WorkerPool &shared();
+};
+
+#endif //WORKER_POOL_WORKER_POOL_H